@@ -0,0 +1,579 @@
+#ifndef CONSTANT_FOLDING_H
+#define CONSTANT_FOLDING_H
+
+#include "LatticeCell.h"
+#include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/APSInt.h"
+#include "llvm/IR/FPEnv.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Operator.h"
+
+namespace lattice
+{
+
+    // An operation as the folding functions see it. Widths are the bits of the result's and first operand's
+    // cells, 0 for values that are neither integers nor floating point, and the semantics are set for
+    // floating-point values. A constrained floating-point intrinsic is described by the operation it constrains.
+    struct OpInfo
+    {
+        unsigned opcode = 0;
+        unsigned predicate = 0;
+        unsigned bitWidth = 0, operandWidth = 0;
+        const llvm::fltSemantics *semantics = nullptr, *operandSemantics = nullptr;
+
+        // Floating-point environment: the rounding mode, whether only exact results that raise no exception
+        // may be folded, whether denormals are flushed, and the fast-math flags
+        llvm::RoundingMode rounding = llvm::RoundingMode::NearestTiesToEven;
+        bool exactOnly = false;
+        bool flushesDenormals = false;
+        llvm::FastMathFlags fastMath;
+
+        // Integer poison flags: nsw, nuw and exact
+        bool noSignedWrap = false, noUnsignedWrap = false, exact = false;
+    };
+
+    // Bits of the lattice cell of a value: the width of an integer or the size of a floating-point value
+    inline unsigned cellWidth(llvm::Type *type)
+    {
+        if (type->isIntegerTy())
+        {
+            return type->getIntegerBitWidth();
+        }
+        return type->isFloatingPointTy() ? type->getPrimitiveSizeInBits().getFixedSize() : 0;
+    }
+
+    // Opcode an instruction is folded as: its own, or the one a constrained intrinsic stands for
+    inline unsigned foldOpcode(const llvm::Instruction &ins)
+    {
+        if (auto *constrained = llvm::dyn_cast<llvm::ConstrainedFPIntrinsic>(&ins))
+        {
+            switch (constrained->getIntrinsicID())
+            {
+#define INSTRUCTION(NAME, NARG, ROUND_MODE, INTRINSIC) \
+    case llvm::Intrinsic::INTRINSIC:                   \
+        return llvm::Instruction::NAME;
+#define FUNCTION(NAME, NARG, ROUND_MODE, INTRINSIC)
+#include "llvm/IR/ConstrainedOps.def"
+            default:
+                break;
+            }
+        }
+        return ins.getOpcode();
+    }
+
+    // Floating-point operations foldFloatOp evaluates
+    constexpr bool isFloatOp(unsigned opcode)
+    {
+        switch (opcode)
+        {
+        case llvm::Instruction::FAdd:
+        case llvm::Instruction::FSub:
+        case llvm::Instruction::FMul:
+        case llvm::Instruction::FDiv:
+        case llvm::Instruction::FRem:
+        case llvm::Instruction::FNeg:
+        case llvm::Instruction::FCmp:
+        case llvm::Instruction::SIToFP:
+        case llvm::Instruction::UIToFP:
+        case llvm::Instruction::FPToSI:
+        case llvm::Instruction::FPToUI:
+        case llvm::Instruction::FPExt:
+        case llvm::Instruction::FPTrunc:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    inline bool isUnaryFloatOp(unsigned opcode)
+    {
+        return opcode != llvm::Instruction::FCmp && !llvm::Instruction::isBinaryOp(opcode);
+    }
+
+    // Describes an instruction for folding. Plain floating-point instructions round to nearest, but only fold
+    // exact results in a strictfp function. A constrained intrinsic folds with its static rounding mode, and
+    // only folds exact results when the rounding mode is dynamic or exceptions are not ignored.
+    inline OpInfo describeOp(const llvm::Instruction &ins)
+    {
+        OpInfo op;
+        op.opcode = foldOpcode(ins);
+        llvm::Type *type = ins.getType();
+        llvm::Type *operandType = ins.getNumOperands() > 0 ? ins.getOperand(0)->getType() : type;
+        op.bitWidth = cellWidth(type);
+        op.operandWidth = cellWidth(operandType);
+        op.semantics = type->isFloatingPointTy() ? &type->getFltSemantics() : nullptr;
+        op.operandSemantics = operandType->isFloatingPointTy() ? &operandType->getFltSemantics() : nullptr;
+        if (auto *cmpInst = llvm::dyn_cast<llvm::CmpInst>(&ins))
+        {
+            op.predicate = cmpInst->getPredicate();
+        }
+        if (llvm::isa<llvm::FPMathOperator>(&ins))
+        {
+            op.fastMath = ins.getFastMathFlags();
+        }
+        if (llvm::isa<llvm::OverflowingBinaryOperator>(&ins))
+        {
+            op.noSignedWrap = ins.hasNoSignedWrap();
+            op.noUnsignedWrap = ins.hasNoUnsignedWrap();
+        }
+        if (llvm::isa<llvm::PossiblyExactOperator>(&ins))
+        {
+            op.exact = ins.isExact();
+        }
+
+        const llvm::Function *F = ins.getFunction();
+        op.exactOnly = F->hasFnAttribute(llvm::Attribute::StrictFP);
+        if (auto *constrained = llvm::dyn_cast<llvm::ConstrainedFPIntrinsic>(&ins))
+        {
+            if (auto *cmpIntrinsic = llvm::dyn_cast<llvm::ConstrainedFPCmpIntrinsic>(constrained))
+            {
+                op.predicate = cmpIntrinsic->getPredicate();
+            }
+            llvm::Optional<llvm::RoundingMode> rounding = constrained->getRoundingMode();
+            llvm::Optional<llvm::fp::ExceptionBehavior> exceptions = constrained->getExceptionBehavior();
+            bool dynamicRounding = rounding && *rounding == llvm::RoundingMode::Dynamic;
+            if (rounding && !dynamicRounding)
+            {
+                op.rounding = *rounding;
+            }
+            op.exactOnly = dynamicRounding || !exceptions || *exceptions != llvm::fp::ebIgnore;
+        }
+
+        for (const llvm::fltSemantics *sem : {op.semantics, op.operandSemantics})
+        {
+            op.flushesDenormals |= sem && F->getDenormalMode(*sem) != llvm::DenormalMode::getIEEE();
+        }
+        return op;
+    }
+
+    inline llvm::APFloat decodeFloat(LatticeCell cell, const llvm::fltSemantics &sem, const ConstantPool &pool)
+    {
+        return llvm::APFloat(sem, pool.decode(cell, llvm::APFloat::semanticsSizeInBits(sem)));
+    }
+
+    inline LatticeCell encodeFloat(const llvm::APFloat &val, ConstantPool &pool)
+    {
+        return pool.encode(val.bitcastToAPInt());
+    }
+
+    // Cell of an integer or floating-point constant; any other constant is not constant
+    inline LatticeCell constantCell(const llvm::Constant *constant, ConstantPool &pool)
+    {
+        if (auto *constInt = llvm::dyn_cast<llvm::ConstantInt>(constant))
+        {
+            return pool.encode(constInt->getValue());
+        }
+        if (auto *constFP = llvm::dyn_cast<llvm::ConstantFP>(constant))
+        {
+            return encodeFloat(constFP->getValueAPF(), pool);
+        }
+        return LatticeCell::overdefined();
+    }
+
+    // Checks a floating-point operand against the fast-math flags and the denormal mode: a NaN under nnan or
+    // an infinity under ninf makes the result poison, and a denormal the hardware may flush is not folded
+    inline bool isFoldableInput(const OpInfo &op, const llvm::APFloat &val)
+    {
+        return !(op.fastMath.noNaNs() && val.isNaN()) && !(op.fastMath.noInfs() && val.isInfinity()) &&
+               !(op.flushesDenormals && val.isDenormal());
+    }
+
+    // Encodes a floating-point result, or makes it not constant when the status or flags forbid folding it
+    inline LatticeCell finishFloat(const OpInfo &op, const llvm::APFloat &result, llvm::APFloat::opStatus status,
+                                   ConstantPool &pool)
+    {
+        if ((op.exactOnly && status != llvm::APFloat::opOK) || !isFoldableInput(op, result))
+        {
+            return LatticeCell::overdefined();
+        }
+        return encodeFloat(result, pool);
+    }
+
+    // Folds a floating-point operation, a conversion to or from floating point, or an fcmp. Unary operations
+    // ignore opr2Val. An undefined operand keeps the result undefined.
+    inline LatticeCell foldFloatOp(const OpInfo &op, LatticeCell opr1Val, LatticeCell opr2Val, ConstantPool &pool)
+    {
+        using llvm::APFloat;
+        using llvm::Instruction;
+        bool unary = isUnaryFloatOp(op.opcode);
+        if (unary)
+        {
+            opr2Val = opr1Val;
+        }
+
+        // x * 0 is 0 for any x under nnan and nsz
+        if (op.opcode == Instruction::FMul && op.semantics && op.fastMath.noNaNs() && op.fastMath.noSignedZeros() && !op.exactOnly)
+        {
+            for (LatticeCell val : {opr1Val, opr2Val})
+            {
+                if (val.isConstant() && decodeFloat(val, *op.semantics, pool).isZero())
+                {
+                    return encodeFloat(APFloat::getZero(*op.semantics), pool);
+                }
+            }
+        }
+
+        if (op.bitWidth == 0 || op.operandWidth == 0 || opr1Val.isOverdefined() || opr2Val.isOverdefined())
+        {
+            return LatticeCell::overdefined();
+        }
+        if (opr1Val.isUndef() || opr2Val.isUndef())
+        {
+            return LatticeCell::undef();
+        }
+
+        switch (op.opcode)
+        {
+        case Instruction::SIToFP:
+        case Instruction::UIToFP:
+        {
+            APFloat result(*op.semantics);
+            APFloat::opStatus status = result.convertFromAPInt(pool.decode(opr1Val, op.operandWidth),
+                                                               op.opcode == Instruction::SIToFP, op.rounding);
+            return finishFloat(op, result, status, pool);
+        }
+        case Instruction::FPToSI:
+        case Instruction::FPToUI:
+        {
+            // Out-of-range and NaN inputs give poison
+            APFloat val = decodeFloat(opr1Val, *op.operandSemantics, pool);
+            llvm::APSInt result(op.bitWidth, op.opcode == Instruction::FPToUI);
+            bool isExact;
+            APFloat::opStatus status = val.convertToInteger(result, llvm::RoundingMode::TowardZero, &isExact);
+            if (!isFoldableInput(op, val) || (status & APFloat::opInvalidOp) || (op.exactOnly && status != APFloat::opOK))
+            {
+                return LatticeCell::overdefined();
+            }
+            return pool.encode(result);
+        }
+        case Instruction::FPExt:
+        case Instruction::FPTrunc:
+        {
+            APFloat result = decodeFloat(opr1Val, *op.operandSemantics, pool);
+            if (!isFoldableInput(op, result))
+            {
+                return LatticeCell::overdefined();
+            }
+            bool losesInfo;
+            APFloat::opStatus status = result.convert(*op.semantics, op.rounding, &losesInfo);
+            return finishFloat(op, result, status, pool);
+        }
+        case Instruction::FCmp:
+        {
+            // Under strict exceptions any NaN may signal, so those compares are left alone
+            APFloat lhs = decodeFloat(opr1Val, *op.operandSemantics, pool);
+            APFloat rhs = decodeFloat(opr2Val, *op.operandSemantics, pool);
+            if (!isFoldableInput(op, lhs) || !isFoldableInput(op, rhs) || (op.exactOnly && (lhs.isNaN() || rhs.isNaN())))
+            {
+                return LatticeCell::overdefined();
+            }
+            return LatticeCell::fromBool(llvm::FCmpInst::compare(lhs, rhs, static_cast<llvm::FCmpInst::Predicate>(op.predicate)));
+        }
+        default:
+            break;
+        }
+
+        APFloat lhs = decodeFloat(opr1Val, *op.semantics, pool);
+        APFloat rhs = decodeFloat(opr2Val, *op.semantics, pool);
+        if (!isFoldableInput(op, lhs) || !isFoldableInput(op, rhs))
+        {
+            return LatticeCell::overdefined();
+        }
+        APFloat::opStatus status = APFloat::opOK;
+        switch (op.opcode)
+        {
+        case Instruction::FNeg:
+            lhs.changeSign();
+            break;
+        case Instruction::FAdd:
+            status = lhs.add(rhs, op.rounding);
+            break;
+        case Instruction::FSub:
+            status = lhs.subtract(rhs, op.rounding);
+            break;
+        case Instruction::FMul:
+            status = lhs.multiply(rhs, op.rounding);
+            break;
+        case Instruction::FDiv:
+            status = lhs.divide(rhs, op.rounding);
+            break;
+        case Instruction::FRem:
+            status = lhs.mod(rhs);
+            break;
+        default:
+            return LatticeCell::overdefined();
+        }
+        return finishFloat(op, lhs, status, pool);
+    }
+
+    // Integer fold over decoded constants. Returns false when the result is poison or the operation is
+    // undefined behaviour; the lattice then keeps the result not constant.
+    typedef bool (*IntFoldFn)(const OpInfo &op, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result);
+
+    inline bool foldAdd(const OpInfo &op, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result)
+    {
+        bool signedOverflow, unsignedOverflow;
+        result = lhs.sadd_ov(rhs, signedOverflow);
+        (void)lhs.uadd_ov(rhs, unsignedOverflow);
+        return !(op.noSignedWrap && signedOverflow) && !(op.noUnsignedWrap && unsignedOverflow);
+    }
+
+    inline bool foldSub(const OpInfo &op, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result)
+    {
+        bool signedOverflow, unsignedOverflow;
+        result = lhs.ssub_ov(rhs, signedOverflow);
+        (void)lhs.usub_ov(rhs, unsignedOverflow);
+        return !(op.noSignedWrap && signedOverflow) && !(op.noUnsignedWrap && unsignedOverflow);
+    }
+
+    inline bool foldMul(const OpInfo &op, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result)
+    {
+        bool signedOverflow, unsignedOverflow;
+        result = lhs.smul_ov(rhs, signedOverflow);
+        (void)lhs.umul_ov(rhs, unsignedOverflow);
+        return !(op.noSignedWrap && signedOverflow) && !(op.noUnsignedWrap && unsignedOverflow);
+    }
+
+    // Shifts by the bit width or more are poison, as are shifted-out bits under nsw, nuw and exact
+    inline bool foldShl(const OpInfo &op, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result)
+    {
+        if (rhs.uge(lhs.getBitWidth()))
+        {
+            return false;
+        }
+        unsigned amount = rhs.getZExtValue();
+        result = lhs.shl(amount);
+        return !(op.noSignedWrap && result.ashr(amount) != lhs) && !(op.noUnsignedWrap && result.lshr(amount) != lhs);
+    }
+
+    inline bool foldLShr(const OpInfo &op, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result)
+    {
+        if (rhs.uge(lhs.getBitWidth()))
+        {
+            return false;
+        }
+        unsigned amount = rhs.getZExtValue();
+        result = lhs.lshr(amount);
+        return !(op.exact && result.shl(amount) != lhs);
+    }
+
+    inline bool foldAShr(const OpInfo &op, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result)
+    {
+        if (rhs.uge(lhs.getBitWidth()))
+        {
+            return false;
+        }
+        unsigned amount = rhs.getZExtValue();
+        result = lhs.ashr(amount);
+        return !(op.exact && result.shl(amount) != lhs);
+    }
+
+    // Division by zero and the signed INT_MIN / -1 overflow are undefined behaviour; an exact division
+    // with a remainder is poison
+    inline bool foldUDiv(const OpInfo &op, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result)
+    {
+        if (rhs.isNullValue() || (op.exact && !lhs.urem(rhs).isNullValue()))
+        {
+            return false;
+        }
+        result = lhs.udiv(rhs);
+        return true;
+    }
+
+    inline bool foldSDiv(const OpInfo &op, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result)
+    {
+        if (rhs.isNullValue() || (lhs.isMinSignedValue() && rhs.isAllOnesValue()) || (op.exact && !lhs.srem(rhs).isNullValue()))
+        {
+            return false;
+        }
+        result = lhs.sdiv(rhs);
+        return true;
+    }
+
+    inline bool foldURem(const OpInfo &, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result)
+    {
+        if (rhs.isNullValue())
+        {
+            return false;
+        }
+        result = lhs.urem(rhs);
+        return true;
+    }
+
+    inline bool foldSRem(const OpInfo &, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result)
+    {
+        if (rhs.isNullValue() || (lhs.isMinSignedValue() && rhs.isAllOnesValue()))
+        {
+            return false;
+        }
+        result = lhs.srem(rhs);
+        return true;
+    }
+
+    inline bool foldAnd(const OpInfo &, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result)
+    {
+        result = lhs & rhs;
+        return true;
+    }
+
+    inline bool foldOr(const OpInfo &, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result)
+    {
+        result = lhs | rhs;
+        return true;
+    }
+
+    inline bool foldXor(const OpInfo &, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result)
+    {
+        result = lhs ^ rhs;
+        return true;
+    }
+
+    inline bool foldTrunc(const OpInfo &op, const llvm::APInt &lhs, const llvm::APInt &, llvm::APInt &result)
+    {
+        result = lhs.trunc(op.bitWidth);
+        return true;
+    }
+
+    inline bool foldZExt(const OpInfo &op, const llvm::APInt &lhs, const llvm::APInt &, llvm::APInt &result)
+    {
+        result = lhs.zext(op.bitWidth);
+        return true;
+    }
+
+    inline bool foldSExt(const OpInfo &op, const llvm::APInt &lhs, const llvm::APInt &, llvm::APInt &result)
+    {
+        result = lhs.sext(op.bitWidth);
+        return true;
+    }
+
+    inline bool foldICmp(const OpInfo &op, const llvm::APInt &lhs, const llvm::APInt &rhs, llvm::APInt &result)
+    {
+        result = llvm::APInt(1, llvm::ICmpInst::compare(lhs, rhs, static_cast<llvm::ICmpInst::Predicate>(op.predicate)));
+        return true;
+    }
+
+    // Operand value that decides an operation whatever the other operand is: 0 for mul and and,
+    // all ones for or
+    enum Absorbing
+    {
+        NoAbsorbing,
+        ZeroAbsorbs,
+        OnesAbsorb
+    };
+
+    // Lattice side of an integer fold. Both operands are decoded at the operand width; unary operations
+    // ignore opr2Val. An absorbing constant decides the result even when the other operand is not constant,
+    // otherwise an undefined operand keeps the result undefined. For an operation with an absorbing value,
+    // an undefined operand could still become it, so it keeps the result undefined even next to a value
+    // that is not constant; the fold stays monotone and does not depend on the visit order.
+    template <IntFoldFn Fold, unsigned NumOperands, Absorbing Absorb>
+    LatticeCell foldIntOp(const OpInfo &op, LatticeCell opr1Val, LatticeCell opr2Val, ConstantPool &pool)
+    {
+        if (op.bitWidth == 0 || op.operandWidth == 0 || op.semantics || op.operandSemantics)
+        {
+            return LatticeCell::overdefined();
+        }
+        if (NumOperands == 1)
+        {
+            opr2Val = opr1Val;
+        }
+        if (Absorb != NoAbsorbing)
+        {
+            if (opr1Val.isUndef() || opr2Val.isUndef())
+            {
+                return LatticeCell::undef();
+            }
+            for (LatticeCell val : {opr1Val, opr2Val})
+            {
+                if (val.isConstant())
+                {
+                    llvm::APInt decoded = pool.decode(val, op.operandWidth);
+                    if (Absorb == ZeroAbsorbs ? decoded.isNullValue() : decoded.isAllOnesValue())
+                    {
+                        return val;
+                    }
+                }
+            }
+        }
+
+        if (opr1Val.isOverdefined() || opr2Val.isOverdefined())
+        {
+            return LatticeCell::overdefined();
+        }
+        if (opr1Val.isUndef() || opr2Val.isUndef())
+        {
+            return LatticeCell::undef();
+        }
+        llvm::APInt result;
+        if (!Fold(op, pool.decode(opr1Val, op.operandWidth), pool.decode(opr2Val, op.operandWidth), result))
+        {
+            return LatticeCell::overdefined();
+        }
+        return pool.encode(result);
+    }
+
+    inline LatticeCell foldNotConstant(const OpInfo &, LatticeCell, LatticeCell, ConstantPool &)
+    {
+        return LatticeCell::overdefined();
+    }
+
+    // Evaluator of one opcode over lattice cells
+    typedef LatticeCell (*FoldFn)(const OpInfo &op, LatticeCell opr1Val, LatticeCell opr2Val, ConstantPool &pool);
+
+    struct FoldTable
+    {
+        FoldFn fns[llvm::Instruction::OtherOpsEnd];
+    };
+
+    // Builds the opcode-indexed evaluator table at compile time
+    constexpr FoldTable makeFoldTable()
+    {
+        using llvm::Instruction;
+        FoldTable table = {};
+        for (unsigned opcode = 0; opcode < Instruction::OtherOpsEnd; ++opcode)
+        {
+            table.fns[opcode] = isFloatOp(opcode) ? foldFloatOp : foldNotConstant;
+        }
+        table.fns[Instruction::Add] = foldIntOp<foldAdd, 2, NoAbsorbing>;
+        table.fns[Instruction::Sub] = foldIntOp<foldSub, 2, NoAbsorbing>;
+        table.fns[Instruction::Mul] = foldIntOp<foldMul, 2, ZeroAbsorbs>;
+        table.fns[Instruction::Shl] = foldIntOp<foldShl, 2, NoAbsorbing>;
+        table.fns[Instruction::LShr] = foldIntOp<foldLShr, 2, NoAbsorbing>;
+        table.fns[Instruction::AShr] = foldIntOp<foldAShr, 2, NoAbsorbing>;
+        table.fns[Instruction::UDiv] = foldIntOp<foldUDiv, 2, NoAbsorbing>;
+        table.fns[Instruction::SDiv] = foldIntOp<foldSDiv, 2, NoAbsorbing>;
+        table.fns[Instruction::URem] = foldIntOp<foldURem, 2, NoAbsorbing>;
+        table.fns[Instruction::SRem] = foldIntOp<foldSRem, 2, NoAbsorbing>;
+        table.fns[Instruction::And] = foldIntOp<foldAnd, 2, ZeroAbsorbs>;
+        table.fns[Instruction::Or] = foldIntOp<foldOr, 2, OnesAbsorb>;
+        table.fns[Instruction::Xor] = foldIntOp<foldXor, 2, NoAbsorbing>;
+        table.fns[Instruction::Trunc] = foldIntOp<foldTrunc, 1, NoAbsorbing>;
+        table.fns[Instruction::ZExt] = foldIntOp<foldZExt, 1, NoAbsorbing>;
+        table.fns[Instruction::SExt] = foldIntOp<foldSExt, 1, NoAbsorbing>;
+        table.fns[Instruction::ICmp] = foldIntOp<foldICmp, 2, NoAbsorbing>;
+        return table;
+    }
+
+    constexpr FoldTable FoldFunctions = makeFoldTable();
+
+    // Whether the evaluator can fold an opcode at all
+    inline bool isFoldable(unsigned opcode)
+    {
+        return opcode < llvm::Instruction::OtherOpsEnd && FoldFunctions.fns[opcode] != foldNotConstant;
+    }
+
+    // Folds an operation over the cells of its first two operands through the evaluator table
+    inline LatticeCell foldOp(const OpInfo &op, LatticeCell opr1Val, LatticeCell opr2Val, ConstantPool &pool)
+    {
+        if (op.opcode >= llvm::Instruction::OtherOpsEnd)
+        {
+            return LatticeCell::overdefined();
+        }
+        return FoldFunctions.fns[op.opcode](op, opr1Val, opr2Val, pool);
+    }
+
+} // end of namespace lattice
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef LATTICE_CELL_H
+#define LATTICE_CELL_H
+
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/DenseMap.h"
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace lattice
+{
+
+    // Lattice value of a fixed-width constant in 8 bytes. A clear low bit holds the constant inline in the
+    // upper 63 bits, low bits 01 hold an index into the function's ConstantPool, and the bit patterns 011
+    // and 111 are undefined (top) and not constant (bottom). Every constant has exactly one encoding, so
+    // two cells of the same width hold the same constant exactly when their bits are equal.
+    struct LatticeCell
+    {
+        uint64_t bits;
+
+        static const uint64_t UndefBits = 3, OverdefinedBits = 7;
+
+        static LatticeCell undef() { return {UndefBits}; }
+        static LatticeCell overdefined() { return {OverdefinedBits}; }
+        static LatticeCell inlineValue(int64_t val) { return {static_cast<uint64_t>(val) << 1}; }
+        static LatticeCell poolValue(uint64_t idx) { return {(idx << 2) | 1}; }
+        static LatticeCell fromBool(bool val) { return inlineValue(val); }
+
+        bool isUndef() const { return bits == UndefBits; }
+        bool isOverdefined() const { return bits == OverdefinedBits; }
+        bool isConstant() const { return (bits & 3) != 3; }
+        bool isInline() const { return (bits & 1) == 0; }
+        int64_t inlineVal() const { return static_cast<int64_t>(bits) >> 1; }
+        uint64_t poolIndex() const { return bits >> 2; }
+
+        bool operator==(LatticeCell other) const { return bits == other.bits; }
+        bool operator!=(LatticeCell other) const { return bits != other.bits; }
+    };
+
+    // Meets two cells: undefined is the identity, and two different constants are not constant
+    inline LatticeCell meetCells(LatticeCell val1, LatticeCell val2)
+    {
+        if (val1 == val2 || val2.isUndef())
+        {
+            return val1;
+        }
+        if (val1.isUndef())
+        {
+            return val2;
+        }
+        return LatticeCell::overdefined();
+    }
+
+    // Per-function store of the constants too wide for an inline cell. Constants narrower than 63 bits are
+    // inlined zero-extended, wider ones inline when their signed value fits in 63 bits. Each pooled constant
+    // is stored once. Inserts are serialized, and reserving room for every constant a solver can create
+    // keeps the storage from moving under concurrent readers.
+    class ConstantPool
+    {
+        std::vector<llvm::APInt> constants;
+        llvm::DenseMap<llvm::APInt, unsigned> indexOf;
+        std::mutex insertMutex;
+
+    public:
+        // Empties the pool, keeping its storage for the next function
+        void reset()
+        {
+            constants.clear();
+            indexOf.clear();
+        }
+
+        void reserve(size_t numMore)
+        {
+            constants.reserve(constants.size() + numMore);
+        }
+
+        LatticeCell encode(const llvm::APInt &val)
+        {
+            if (val.getBitWidth() < 63)
+            {
+                return LatticeCell::inlineValue(val.getZExtValue());
+            }
+            if (val.getMinSignedBits() <= 63)
+            {
+                return LatticeCell::inlineValue(val.getSExtValue());
+            }
+            std::lock_guard<std::mutex> lock(insertMutex);
+            auto inserted = indexOf.insert({val, static_cast<unsigned>(constants.size())});
+            if (inserted.second)
+            {
+                constants.push_back(val);
+            }
+            return LatticeCell::poolValue(inserted.first->second);
+        }
+
+        // Decodes a constant cell of the given bit width
+        llvm::APInt decode(LatticeCell cell, unsigned bitWidth) const
+        {
+            if (!cell.isInline())
+            {
+                return constants[cell.poolIndex()];
+            }
+            return llvm::APInt(bitWidth, cell.inlineVal(), bitWidth >= 63);
+        }
+    };
+
+} // end of namespace lattice
+
+#endif
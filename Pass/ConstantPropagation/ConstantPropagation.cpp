@@ -1,5 +1,9 @@
 #include "llvm/Pass.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/MemoryLocation.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Function.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/IR/Type.h"
@@ -7,289 +11,1521 @@
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "ConstantFolding.h"
 #include <string>
-#include <sstream>
 #include <fstream>
-#include <map>
+#include <numeric>
 #include <set>
-#include <queue>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 using namespace llvm;
 using namespace std;
+using namespace lattice;
 
 #define DEBUG_TYPE "ConstantPropagation"
 
+static cl::opt<bool> DebugOutput("cp-debug", cl::desc("Print the IN/OUT lattice of every visited block"), cl::init(false));
+static cl::opt<bool> ReportStats("cp-report", cl::desc("Print per-function solver statistics"), cl::init(false));
+enum SolverKind
+{
+    WorklistSolver,
+    LoopNestSolver
+};
+static cl::opt<SolverKind> Solver("cp-solver", cl::desc("Fixed-point solver of the iterative pass"),
+                                  cl::values(clEnumValN(WorklistSolver, "worklist", "Reverse post-order worklist"),
+                                             clEnumValN(LoopNestSolver, "loopnest", "Solve each loop of the loop nest to a local fixed point, innermost first")),
+                                  cl::init(WorklistSolver));
+enum KernelKind
+{
+    AutoKernel,
+    ScalarKernel,
+    SSE42Kernel,
+    AVX2Kernel
+};
+static cl::opt<KernelKind> Kernel("cp-kernel", cl::desc("Meet and equality kernels used on lattice leaves"),
+                                  cl::values(clEnumValN(AutoKernel, "auto", "Widest kernels the CPU supports"),
+                                             clEnumValN(ScalarKernel, "scalar", "Portable scalar kernels"),
+                                             clEnumValN(SSE42Kernel, "sse4.2", "SSE4.2 kernels when supported"),
+                                             clEnumValN(AVX2Kernel, "avx2", "AVX2 kernels when supported")),
+                                  cl::init(AutoKernel));
+static cl::opt<bool> SparseMode("cp-sparse", cl::desc("Only meet, transfer and compare the slots that changed since a block's last visit"), cl::init(false));
+
 namespace
 {
 
-    struct ConstantPropagation : public FunctionPass
-    {
-        static char ID;
-        ConstantPropagation() : FunctionPass(ID) {}
+    // Leaf kernels. A meet kernel meets the live lanes of src into dst, writes the result and returns
+    // LeafDiffersFromDst / LeafDiffersFromSrc flags; an equality kernel compares two leaves.
+    const unsigned LeafDiffersFromDst = 1;
+    const unsigned LeafDiffersFromSrc = 2;
+    typedef unsigned (*LeafMeetKernel)(const LatticeCell *dst, const LatticeCell *src, uint64_t live, LatticeCell *result);
+    typedef bool (*LeafEqualKernel)(const LatticeCell *cells1, const LatticeCell *cells2);
+
+    template <unsigned LeafSize>
+    unsigned meetLeafScalar(const LatticeCell *dst, const LatticeCell *src, uint64_t live, LatticeCell *result)
+    {
+        unsigned flags = 0;
+        for (unsigned idx = 0; idx < LeafSize; ++idx)
+        {
+            result[idx] = ((live >> idx) & 1) ? meetCells(dst[idx], src[idx]) : dst[idx];
+            flags |= (result[idx] != dst[idx] ? LeafDiffersFromDst : 0) | (result[idx] != src[idx] ? LeafDiffersFromSrc : 0);
+        }
+        return flags;
+    }
+
+    template <unsigned LeafSize>
+    bool equalLeafScalar(const LatticeCell *cells1, const LatticeCell *cells2)
+    {
+        return std::equal(cells1, cells1 + LeafSize, cells2);
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    // The vector meet works on the 64-bit cell encodings: equal lanes keep their value, different lanes
+    // become overdefined, and a lane that is undefined on one side takes the other side's value.
+    // Overdefined on either side falls out of these rules.
+    template <unsigned LeafSize>
+    __attribute__((target("sse4.2"))) unsigned meetLeafSSE42(const LatticeCell *dst, const LatticeCell *src, uint64_t live, LatticeCell *result)
+    {
+        const __m128i undef = _mm_set1_epi64x(LatticeCell::UndefBits), nac = _mm_set1_epi64x(LatticeCell::OverdefinedBits);
+        const __m128i laneBits = _mm_set_epi64x(2, 1);
+        __m128i differsFromDst = _mm_setzero_si128(), differsFromSrc = _mm_setzero_si128();
+        for (unsigned idx = 0; idx < LeafSize; idx += 2)
+        {
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + idx));
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + idx));
+            __m128i r = _mm_blendv_epi8(nac, d, _mm_cmpeq_epi64(d, s));
+            r = _mm_blendv_epi8(r, s, _mm_cmpeq_epi64(d, undef));
+            r = _mm_blendv_epi8(r, d, _mm_cmpeq_epi64(s, undef));
+            __m128i liveLanes = _mm_cmpeq_epi64(_mm_and_si128(_mm_set1_epi64x((live >> idx) & 0x3), laneBits), laneBits);
+            r = _mm_blendv_epi8(d, r, liveLanes);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(result + idx), r);
+            differsFromDst = _mm_or_si128(differsFromDst, _mm_xor_si128(r, d));
+            differsFromSrc = _mm_or_si128(differsFromSrc, _mm_xor_si128(r, s));
+        }
+        return (_mm_testz_si128(differsFromDst, differsFromDst) ? 0 : LeafDiffersFromDst) |
+               (_mm_testz_si128(differsFromSrc, differsFromSrc) ? 0 : LeafDiffersFromSrc);
+    }
+
+    template <unsigned LeafSize>
+    __attribute__((target("sse4.2"))) bool equalLeafSSE42(const LatticeCell *cells1, const LatticeCell *cells2)
+    {
+        __m128i diff = _mm_setzero_si128();
+        for (unsigned idx = 0; idx < LeafSize; idx += 2)
+        {
+            diff = _mm_or_si128(diff, _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(cells1 + idx)),
+                                                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(cells2 + idx))));
+        }
+        return _mm_testz_si128(diff, diff);
+    }
+
+    template <unsigned LeafSize>
+    __attribute__((target("avx2"))) unsigned meetLeafAVX2(const LatticeCell *dst, const LatticeCell *src, uint64_t live, LatticeCell *result)
+    {
+        const __m256i undef = _mm256_set1_epi64x(LatticeCell::UndefBits), nac = _mm256_set1_epi64x(LatticeCell::OverdefinedBits);
+        const __m256i laneBits = _mm256_setr_epi64x(1, 2, 4, 8);
+        __m256i differsFromDst = _mm256_setzero_si256(), differsFromSrc = _mm256_setzero_si256();
+        for (unsigned idx = 0; idx < LeafSize; idx += 4)
+        {
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + idx));
+            __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + idx));
+            __m256i r = _mm256_blendv_epi8(nac, d, _mm256_cmpeq_epi64(d, s));
+            r = _mm256_blendv_epi8(r, s, _mm256_cmpeq_epi64(d, undef));
+            r = _mm256_blendv_epi8(r, d, _mm256_cmpeq_epi64(s, undef));
+            __m256i liveLanes = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x((live >> idx) & 0xf), laneBits), laneBits);
+            r = _mm256_blendv_epi8(d, r, liveLanes);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + idx), r);
+            differsFromDst = _mm256_or_si256(differsFromDst, _mm256_xor_si256(r, d));
+            differsFromSrc = _mm256_or_si256(differsFromSrc, _mm256_xor_si256(r, s));
+        }
+        return (_mm256_testz_si256(differsFromDst, differsFromDst) ? 0 : LeafDiffersFromDst) |
+               (_mm256_testz_si256(differsFromSrc, differsFromSrc) ? 0 : LeafDiffersFromSrc);
+    }
+
+    template <unsigned LeafSize>
+    __attribute__((target("avx2"))) bool equalLeafAVX2(const LatticeCell *cells1, const LatticeCell *cells2)
+    {
+        __m256i diff = _mm256_setzero_si256();
+        for (unsigned idx = 0; idx < LeafSize; idx += 4)
+        {
+            diff = _mm256_or_si256(diff, _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(cells1 + idx)),
+                                                          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cells2 + idx))));
+        }
+        return _mm256_testz_si256(diff, diff);
+    }
+#endif
+
+    // Picks the widest leaf kernels the CPU supports, unless -cp-kernel asks for a specific set
+    template <unsigned LeafSize>
+    std::pair<LeafMeetKernel, LeafEqualKernel> pickLeafKernels()
+    {
+        LeafMeetKernel meetLeaf = meetLeafScalar<LeafSize>;
+        LeafEqualKernel equalLeaf = equalLeafScalar<LeafSize>;
+#if defined(__x86_64__) || defined(__i386__)
+        bool avx2 = __builtin_cpu_supports("avx2"), sse42 = __builtin_cpu_supports("sse4.2");
+        if (avx2 && (Kernel == AutoKernel || Kernel == AVX2Kernel))
+        {
+            meetLeaf = meetLeafAVX2<LeafSize>;
+            equalLeaf = equalLeafAVX2<LeafSize>;
+        }
+        else if (sse42 && (Kernel == AutoKernel || Kernel == SSE42Kernel))
+        {
+            meetLeaf = meetLeafSSE42<LeafSize>;
+            equalLeaf = equalLeafSSE42<LeafSize>;
+        }
+#endif
+        return {meetLeaf, equalLeaf};
+    }
+
+    // Hands out the leaf kernels, picked on the first call, once the command line has been parsed
+    template <unsigned LeafSize>
+    void selectLeafKernels(LeafMeetKernel &meetLeaf, LeafEqualKernel &equalLeaf)
+    {
+        static const std::pair<LeafMeetKernel, LeafEqualKernel> picked = pickLeafKernels<LeafSize>();
+        meetLeaf = picked.first;
+        equalLeaf = picked.second;
+    }
+
+    // Persistent trie of lattice cells indexed by slot. Block states are roots into the trie and
+    // share every subtree they do not write; nodes are reference counted and copied on write. Released
+    // nodes go to a free list that outlives the function, so later functions reuse them.
+    class LatticeStore
+    {
+    public:
+        static const unsigned LeafBits = 6, BranchBits = 6;
+        static const unsigned LeafSize = 1u << LeafBits, Fanout = 1u << BranchBits;
+
+        struct Node
+        {
+            unsigned refs;
+            union
+            {
+                Node *kids[Fanout];
+                LatticeCell cells[LeafSize];
+            };
+        };
+
+        // Sizes the trie for the given number of slots
+        void reset(unsigned numSlots)
+        {
+            selectLeafKernels<LeafSize>(meetLeaf, equalLeaf);
+            height = 0;
+            for (uint64_t capacity = LeafSize; capacity < numSlots; capacity <<= BranchBits)
+            {
+                ++height;
+            }
+            liveNodes = peakNodes = 0;
+        }
+
+        // Builds a state with every slot set to the same value; all subtrees at a level are shared
+        Node *makeUniform(LatticeCell val)
+        {
+            Node *node = allocate();
+            std::fill(std::begin(node->cells), std::end(node->cells), val);
+            for (unsigned level = 1; level <= height; ++level)
+            {
+                Node *parent = allocate();
+                for (unsigned idx = 0; idx < Fanout; ++idx)
+                {
+                    parent->kids[idx] = retain(node);
+                }
+                release(node, level - 1);
+                node = parent;
+            }
+            return node;
+        }
+
+        Node *retain(Node *node)
+        {
+            ++node->refs;
+            return node;
+        }
+
+        void release(Node *root)
+        {
+            release(root, height);
+        }
+
+        LatticeCell get(const Node *root, unsigned slot) const
+        {
+            for (unsigned level = height; level > 0; --level)
+            {
+                root = root->kids[childIndex(slot, level)];
+            }
+            return root->cells[slot & (LeafSize - 1)];
+        }
+
+        // Writes one slot, copying the nodes on its path that are shared with other states
+        void set(Node *&root, unsigned slot, LatticeCell val)
+        {
+            if (get(root, slot) == val)
+            {
+                return;
+            }
+            Node **ref = &root;
+            for (unsigned level = height;; --level)
+            {
+                makeWritable(*ref, level);
+                if (level == 0)
+                {
+                    (*ref)->cells[slot & (LeafSize - 1)] = val;
+                    return;
+                }
+                ref = &(*ref)->kids[childIndex(slot, level)];
+            }
+        }
+
+        // Meets src into dst for the slots set in liveWords (one 64-bit word per leaf); other slots
+        // keep their value. Returns true if dst changed.
+        bool meetInto(Node *&dst, Node *src, ArrayRef<uint64_t> liveWords)
+        {
+            return meetInto(dst, src, height, 0, liveWords);
+        }
+
+        bool equal(const Node *node1, const Node *node2) const
+        {
+            return equal(node1, node2, height);
+        }
+
+        size_t peakBytes() const { return peakNodes * sizeof(Node); }
+        size_t liveBytes() const { return liveNodes * sizeof(Node); }
+
+        LatticeStore() = default;
+        LatticeStore(const LatticeStore &) = delete;
+        LatticeStore &operator=(const LatticeStore &) = delete;
+
+        ~LatticeStore()
+        {
+            for (Node *node : freeNodes)
+            {
+                delete node;
+            }
+        }
+
+    private:
+        unsigned height = 0;
+        size_t liveNodes = 0, peakNodes = 0;
+        vector<Node *> freeNodes;
+        LeafMeetKernel meetLeaf = meetLeafScalar<LeafSize>;
+        LeafEqualKernel equalLeaf = equalLeafScalar<LeafSize>;
+
+        static unsigned childIndex(unsigned slot, unsigned level)
+        {
+            return (slot >> (LeafBits + BranchBits * (level - 1))) & (Fanout - 1);
+        }
+
+        Node *allocate()
+        {
+            Node *node;
+            if (freeNodes.empty())
+            {
+                node = new Node;
+            }
+            else
+            {
+                node = freeNodes.back();
+                freeNodes.pop_back();
+            }
+            node->refs = 1;
+            peakNodes = std::max(peakNodes, ++liveNodes);
+            return node;
+        }
+
+        void release(Node *node, unsigned level)
+        {
+            if (--node->refs > 0)
+            {
+                return;
+            }
+            if (level > 0)
+            {
+                for (Node *kid : node->kids)
+                {
+                    release(kid, level - 1);
+                }
+            }
+            freeNodes.push_back(node);
+            --liveNodes;
+        }
+
+        // Replaces a shared node by a private copy
+        void makeWritable(Node *&node, unsigned level)
+        {
+            if (node->refs == 1)
+            {
+                return;
+            }
+            Node *copy = allocate();
+            if (level == 0)
+            {
+                std::copy(std::begin(node->cells), std::end(node->cells), copy->cells);
+            }
+            else
+            {
+                for (unsigned idx = 0; idx < Fanout; ++idx)
+                {
+                    copy->kids[idx] = retain(node->kids[idx]);
+                }
+            }
+            --node->refs;
+            node = copy;
+        }
+
+        bool meetInto(Node *&dst, Node *src, unsigned level, unsigned firstSlot, ArrayRef<uint64_t> liveWords)
+        {
+            if (dst == src)
+            {
+                return false;
+            }
+
+            if (level == 0)
+            {
+                unsigned wordIdx = firstSlot >> LeafBits;
+                uint64_t live = wordIdx < liveWords.size() ? liveWords[wordIdx] : 0;
+                if (live == 0)
+                {
+                    return false;
+                }
+                LatticeCell result[LeafSize];
+                unsigned flags = meetLeaf(dst->cells, src->cells, live, result);
+                if (!(flags & LeafDiffersFromDst))
+                {
+                    return false;
+                }
+                if (!(flags & LeafDiffersFromSrc))
+                {
+                    // The meet is exactly src, so share its leaf
+                    release(dst, 0);
+                    dst = retain(src);
+                    return true;
+                }
+                makeWritable(dst, 0);
+                std::copy(std::begin(result), std::end(result), dst->cells);
+                return true;
+            }
+
+            bool changed = false, sameAsSrc = true;
+            unsigned kidSpan = 1u << (LeafBits + BranchBits * (level - 1));
+            for (unsigned idx = 0; idx < Fanout; ++idx)
+            {
+                if (dst->kids[idx] == src->kids[idx])
+                {
+                    continue;
+                }
+                unsigned kidFirstSlot = firstSlot + idx * kidSpan;
+                if (dst->refs == 1)
+                {
+                    changed |= meetInto(dst->kids[idx], src->kids[idx], level - 1, kidFirstSlot, liveWords);
+                }
+                else
+                {
+                    // dst is shared: meet into a new reference and only copy dst if the kid moved
+                    Node *kid = retain(dst->kids[idx]);
+                    if (meetInto(kid, src->kids[idx], level - 1, kidFirstSlot, liveWords))
+                    {
+                        makeWritable(dst, level);
+                        release(dst->kids[idx], level - 1);
+                        dst->kids[idx] = kid;
+                        changed = true;
+                    }
+                    else
+                    {
+                        release(kid, level - 1);
+                    }
+                }
+                sameAsSrc &= dst->kids[idx] == src->kids[idx];
+            }
+            if (changed && sameAsSrc)
+            {
+                release(dst, level);
+                dst = retain(src);
+            }
+            return changed;
+        }
+
+        bool equal(const Node *node1, const Node *node2, unsigned level) const
+        {
+            if (node1 == node2)
+            {
+                return true;
+            }
+            if (level == 0)
+            {
+                return equalLeaf(node1->cells, node2->cells);
+            }
+            for (unsigned idx = 0; idx < Fanout; ++idx)
+            {
+                if (!equal(node1->kids[idx], node2->kids[idx], level - 1))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    // Resizes a vector of lists to hold n empty lists. The vector never shrinks, so the lists keep
+    // their storage for the next function.
+    template <typename ListT>
+    void resetLists(vector<ListT> &lists, unsigned n)
+    {
+        if (lists.size() < n)
+        {
+            lists.resize(n);
+        }
+        for (unsigned idx = 0; idx < n; ++idx)
+        {
+            lists[idx].clear();
+        }
+    }
+
+    // Resizes a vector of bitsets to hold n cleared bitsets of numBits bits, keeping their storage
+    void resetBitVectors(vector<BitVector> &bitsets, unsigned n, unsigned numBits)
+    {
+        if (bitsets.size() < n)
+        {
+            bitsets.resize(n);
+        }
+        for (unsigned idx = 0; idx < n; ++idx)
+        {
+            bitsets[idx].clear();
+            bitsets[idx].resize(numBits);
+        }
+    }
+
+    struct ConstantPropagation : public FunctionPass
+    {
+        static char ID;
+        ConstantPropagation() : FunctionPass(ID) {}
+
+        // Extracts the register name from a value
+        std::string getRegisterNameFromValue(Value *valueIns)
+        {
+            std::string registerName;
+            llvm::raw_string_ostream rso(registerName);
+            valueIns->printAsOperand(rso, false);
+            rso.flush();
+            return registerName;
+        }
+
+        // Operand of a transfer op: a slot, or a constant when slot is NoSlot
+        struct TransferOperand
+        {
+            static const unsigned NoSlot = ~0u;
+            unsigned slot;
+            LatticeCell constVal;
+        };
+
+        // One step of a block's precompiled transfer function over slot indices. Ops that evaluate an
+        // instruction carry its description for the folding functions.
+        struct TransferOp : OpInfo
+        {
+            enum Kind : uint8_t
+            {
+                StoreConst, // dst = lhs.constVal
+                Copy,       // dst = lhs
+                Fold,       // dst = foldOp(lhs, rhs)
+                BranchTest  // branch condition = lhs
+            };
+            Kind kind;
+            unsigned dst;
+            TransferOperand lhs, rhs;
+        };
+
+        // Per-function lattice state, indexed by dense slot and block numbers
+        struct FunctionLattice
+        {
+            DenseMap<const Value *, unsigned> slotOf;
+            vector<Value *> slotValues;
+
+            // Memory cells: an underlying object, a constant byte offset into it and the accessed type.
+            // Their slots follow the value slots, and each simple load or store maps to the cell it accesses.
+            struct MemoryCell
+            {
+                const Value *base;
+                int64_t offset;
+                MemoryLocation loc;
+                Type *type;
+            };
+            vector<MemoryCell> cells;
+            unsigned firstCellSlot = 0;
+            DenseMap<std::tuple<const Value *, int64_t, Type *>, unsigned> cellOf;
+            DenseMap<const Instruction *, unsigned> cellOfAccess;
+            vector<SmallVector<unsigned, 2>> overlapping;
+            DenseMap<BasicBlock *, unsigned> blockNum;
+            vector<BasicBlock *> blocks;
+            LatticeStore store;
+            vector<LatticeStore::Node *> IN, OUT;
+
+            // Transfer programs of all blocks, block b owning ops[programStart[b]..programStart[b + 1])
+            vector<TransferOp> ops;
+            vector<unsigned> programStart;
+
+            // Slots each block reads or writes; sparse mode also keeps the slots changed since its last visit
+            vector<vector<unsigned>> footprint, writes;
+            vector<BitVector> reads, written, pending;
+            vector<vector<unsigned>> pendingSlots;
+            BitVector visited;
+            vector<LatticeCell> scratch;
+
+            // Liveness: slots read before being written in a block, slots live at block entry and exit,
+            // written slots still live at exit, and slots that die inside the block
+            vector<BitVector> exposed, liveIn, liveOut;
+            vector<vector<unsigned>> storeBack, killed;
+
+            // Branch condition value of each block's last transfer, and each slot's value where it is defined
+            vector<LatticeCell> condVal;
+            vector<LatticeCell> slotResult;
+
+            // Constants too wide to inline in a cell
+            ConstantPool pool;
+
+            // Solver bookkeeping: visit count, changed slots of the last visit, and the loop-nest solver's
+            // logical time of each block's last change
+            unsigned blockVisits = 0;
+            vector<unsigned> changedOut;
+            vector<unsigned> lastChange;
+            unsigned changeClock = 0;
+
+            // Loop-nest solver: each loop's non-header blocks are loopBlocks[bodyStart..bodyEnd), and solvedAt
+            // is the logical time its last solve finished
+            struct LoopSummary
+            {
+                unsigned bodyStart, bodyEnd;
+                unsigned solvedAt;
+                bool solved;
+            };
+            vector<unsigned> loopBlocks;
+            DenseMap<const Loop *, LoopSummary> loops;
+
+            // Scratch storage of the pre-passes and the sparse visit
+            vector<std::pair<BasicBlock *, unsigned>> dfsStack;
+            DenseMap<const Value *, SmallVector<unsigned, 4>> cellsOfBase;
+            BitVector scratchBits;
+            vector<unsigned> changedIn;
+            vector<unsigned> allBlocks;
+
+            // Empties the per-function containers but keeps their storage for the next function; the
+            // nested per-block lists are reset where they are sized
+            void clear()
+            {
+                slotOf.clear();
+                slotValues.clear();
+                cells.clear();
+                cellOf.clear();
+                cellOfAccess.clear();
+                blockNum.clear();
+                blocks.clear();
+                IN.clear();
+                OUT.clear();
+                visited.clear();
+                blockVisits = 0;
+                changedOut.clear();
+                changeClock = 0;
+                loopBlocks.clear();
+                loops.clear();
+                pool.reset();
+            }
+        };
+
+        // Checks if an instruction defines a value tracked by the lattice
+        bool isTrackedInstruction(const Instruction &ins)
+        {
+            return isa<LoadInst>(&ins) || isFoldable(foldOpcode(ins));
+        }
+
+        // Worklist that pops blocks in reverse post-order and holds each block at most once
+        class BlockWorklist
+        {
+            vector<unsigned> heap;
+            BitVector queued;
+
+        public:
+            // Empties the worklist for a function with numBlocks blocks, keeping its storage
+            void reset(unsigned numBlocks)
+            {
+                heap.clear();
+                queued.clear();
+                queued.resize(numBlocks);
+            }
+
+            void push(unsigned blockIdx)
+            {
+                if (!queued.test(blockIdx))
+                {
+                    queued.set(blockIdx);
+                    heap.push_back(blockIdx);
+                    std::push_heap(heap.begin(), heap.end(), std::greater<unsigned>());
+                }
+            }
+
+            unsigned pop()
+            {
+                std::pop_heap(heap.begin(), heap.end(), std::greater<unsigned>());
+                unsigned blockIdx = heap.back();
+                heap.pop_back();
+                queued.reset(blockIdx);
+                return blockIdx;
+            }
+
+            bool empty() const { return heap.empty(); }
+        };
+
+        // Lattice and worklist storage reused by every runOnFunction call
+        FunctionLattice Lattice;
+        BlockWorklist Worklist;
+
+        // Numbers the blocks in reverse post-order, unreachable blocks last. The depth-first search keeps
+        // its stack in the lattice instead of allocating a traversal per function.
+        void numberBlocks(Function &F, FunctionLattice &L)
+        {
+            BasicBlock *entry = &F.getEntryBlock();
+            L.blockNum[entry] = 0;
+            L.dfsStack.push_back({entry, 0});
+            while (!L.dfsStack.empty())
+            {
+                BasicBlock *BB = L.dfsStack.back().first;
+                unsigned succNo = L.dfsStack.back().second++;
+                Instruction *terminator = BB->getTerminator();
+                if (succNo < terminator->getNumSuccessors())
+                {
+                    BasicBlock *succ = terminator->getSuccessor(succNo);
+                    if (L.blockNum.try_emplace(succ, 0).second)
+                    {
+                        L.dfsStack.push_back({succ, 0});
+                    }
+                }
+                else
+                {
+                    L.blocks.push_back(BB);
+                    L.dfsStack.pop_back();
+                }
+            }
+            std::reverse(L.blocks.begin(), L.blocks.end());
+            for (unsigned blockIdx = 0; blockIdx < L.blocks.size(); ++blockIdx)
+            {
+                L.blockNum[L.blocks[blockIdx]] = blockIdx;
+            }
+
+            for (auto &BB : F)
+            {
+                if (L.blockNum.try_emplace(&BB, L.blocks.size()).second)
+                {
+                    L.blocks.push_back(&BB);
+                }
+            }
+        }
+
+        // Gives every tracked value a dense slot index, in instruction order
+        void numberSlots(Function &F, FunctionLattice &L)
+        {
+            for (auto &BB : F)
+            {
+                for (auto &ins : BB)
+                {
+                    if (isTrackedInstruction(ins))
+                    {
+                        L.slotOf[&ins] = L.slotValues.size();
+                        L.slotValues.push_back(&ins);
+                    }
+                }
+            }
+        }
+
+        // Gives a slot to every memory cell a simple load or store accesses at a constant offset from an
+        // alloca or global, and records which cells of the same object overlap
+        void numberMemoryCells(Function &F, FunctionLattice &L)
+        {
+            const DataLayout &DL = F.getParent()->getDataLayout();
+            L.firstCellSlot = L.slotValues.size();
+            for (auto &BB : F)
+            {
+                for (auto &ins : BB)
+                {
+                    if (!(isa<LoadInst>(&ins) || isa<StoreInst>(&ins)) ||
+                        (isa<LoadInst>(&ins) ? !cast<LoadInst>(&ins)->isSimple() : !cast<StoreInst>(&ins)->isSimple()))
+                    {
+                        continue;
+                    }
+                    MemoryLocation loc = MemoryLocation::get(&ins);
+                    Type *type = getLoadStoreType(&ins);
+                    int64_t offset = 0;
+                    const Value *base = GetPointerBaseWithConstantOffset(loc.Ptr, offset, DL);
+                    if (!(isa<AllocaInst>(base) || isa<GlobalVariable>(base)) || !loc.Size.isPrecise())
+                    {
+                        continue;
+                    }
+                    auto inserted = L.cellOf.insert({std::make_tuple(base, offset, type), L.slotValues.size()});
+                    if (inserted.second)
+                    {
+                        L.cells.push_back({base, offset, loc, type});
+                        L.slotValues.push_back(const_cast<Value *>(loc.Ptr));
+                    }
+                    L.cellOfAccess[&ins] = inserted.first->second;
+                }
+            }
+
+            // Cells of one object overlap when their byte ranges intersect
+            auto &cellsOfBase = L.cellsOfBase;
+            cellsOfBase.clear();
+            for (unsigned cellIdx = 0; cellIdx < L.cells.size(); ++cellIdx)
+            {
+                cellsOfBase[L.cells[cellIdx].base].push_back(cellIdx);
+            }
+            resetLists(L.overlapping, L.cells.size());
+            for (auto &entry : cellsOfBase)
+            {
+                for (unsigned cellA : entry.second)
+                {
+                    for (unsigned cellB : entry.second)
+                    {
+                        const auto &a = L.cells[cellA], &b = L.cells[cellB];
+                        if (cellA != cellB && a.offset < b.offset + static_cast<int64_t>(b.loc.Size.getValue()) &&
+                            b.offset < a.offset + static_cast<int64_t>(a.loc.Size.getValue()))
+                        {
+                            L.overlapping[cellA].push_back(L.firstCellSlot + cellB);
+                        }
+                    }
+                }
+            }
+        }
+
+        // Encodes an operand as a slot, a constant, or an overdefined constant for untracked values
+        TransferOperand makeOperand(Value *opr, FunctionLattice &L)
+        {
+            if (auto *constant = dyn_cast<Constant>(opr))
+            {
+                return {TransferOperand::NoSlot, constantCell(constant, L.pool)};
+            }
+            auto it = L.slotOf.find(opr);
+            if (it == L.slotOf.end())
+            {
+                return {TransferOperand::NoSlot, LatticeCell::overdefined()};
+            }
+            return {it->second, LatticeCell::undef()};
+        }
+
+        // Type of the values a slot holds
+        Type *slotType(unsigned slot, const FunctionLattice &L)
+        {
+            return slot < L.firstCellSlot ? L.slotValues[slot]->getType() : L.cells[slot - L.firstCellSlot].type;
+        }
+
+        // Compiles every block's instructions once into a transfer program over slot indices. A store to a
+        // known cell also resets the cells overlapping it, and any other memory write resets the cells
+        // alias analysis says it may modify.
+        void compilePrograms(FunctionLattice &L, AAResults &AA)
+        {
+            BatchAAResults batchAA(AA);
+            L.ops.clear();
+            L.programStart.clear();
+            auto clobber = [&L](unsigned slot) {
+                TransferOp op = {};
+                op.kind = TransferOp::StoreConst;
+                op.dst = slot;
+                op.lhs = {TransferOperand::NoSlot, LatticeCell::overdefined()};
+                L.ops.push_back(op);
+            };
+
+            for (BasicBlock *block : L.blocks)
+            {
+                L.programStart.push_back(L.ops.size());
+                for (auto &ins : *block)
+                {
+                    auto cellIt = L.cellOfAccess.find(&ins);
+                    unsigned cellSlot = cellIt == L.cellOfAccess.end() ? TransferOperand::NoSlot : cellIt->second;
+                    TransferOp op = {};
+                    if (auto *storeInst = dyn_cast<StoreInst>(&ins))
+                    {
+                        if (cellSlot != TransferOperand::NoSlot)
+                        {
+                            op.dst = cellSlot;
+                            op.lhs = makeOperand(storeInst->getValueOperand(), L);
+                            op.kind = op.lhs.slot == TransferOperand::NoSlot ? TransferOp::StoreConst : TransferOp::Copy;
+                            L.ops.push_back(op);
+                            for (unsigned otherSlot : L.overlapping[cellSlot - L.firstCellSlot])
+                            {
+                                clobber(otherSlot);
+                            }
+                            continue;
+                        }
+                    }
+                    else if (isa<LoadInst>(&ins))
+                    {
+                        op.dst = L.slotOf.lookup(&ins);
+                        op.lhs = {cellSlot, LatticeCell::overdefined()};
+                        op.kind = op.lhs.slot == TransferOperand::NoSlot ? TransferOp::StoreConst : TransferOp::Copy;
+                        L.ops.push_back(op);
+                    }
+                    else if (isFoldable(foldOpcode(ins)))
+                    {
+                        static_cast<OpInfo &>(op) = describeOp(ins);
+                        op.kind = TransferOp::Fold;
+                        op.dst = L.slotOf.lookup(&ins);
+                        op.lhs = makeOperand(ins.getOperand(0), L);
+                        op.rhs = ins.getNumOperands() > 1 ? makeOperand(ins.getOperand(1), L)
+                                                          : TransferOperand{TransferOperand::NoSlot, LatticeCell::undef()};
+                        L.ops.push_back(op);
+                    }
+                    else if (auto *brInst = dyn_cast<BranchInst>(&ins))
+                    {
+                        if (brInst->isConditional())
+                        {
+                            op.kind = TransferOp::BranchTest;
+                            op.lhs = makeOperand(brInst->getCondition(), L);
+                            L.ops.push_back(op);
+                        }
+                    }
+
+                    if (ins.mayWriteToMemory())
+                    {
+                        for (unsigned cellIdx = 0; cellIdx < L.cells.size(); ++cellIdx)
+                        {
+                            if (isModSet(batchAA.getModRefInfo(&ins, L.cells[cellIdx].loc)))
+                            {
+                                clobber(L.firstCellSlot + cellIdx);
+                            }
+                        }
+                    }
+                }
+            }
+            L.programStart.push_back(L.ops.size());
+        }
+
+        // Records the slots each block's program reads and writes
+        void computeFootprints(FunctionLattice &L)
+        {
+            unsigned numSlots = L.slotValues.size();
+            unsigned numBlocks = L.blocks.size();
+            resetLists(L.footprint, numBlocks);
+            resetLists(L.writes, numBlocks);
+            resetBitVectors(L.reads, numBlocks, numSlots);
+            resetBitVectors(L.exposed, numBlocks, numSlots);
+            resetBitVectors(L.written, numBlocks, numSlots);
+            resetBitVectors(L.pending, numBlocks, numSlots);
+            resetLists(L.pendingSlots, numBlocks);
+            L.visited.resize(numBlocks);
+            L.scratch.assign(numSlots, LatticeCell::undef());
+
+            for (unsigned blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+            {
+                BitVector &written = L.written[blockIdx];
+                auto addRead = [&](const TransferOperand &opr) {
+                    if (opr.slot != TransferOperand::NoSlot)
+                    {
+                        L.reads[blockIdx].set(opr.slot);
+                        if (!written.test(opr.slot))
+                        {
+                            L.exposed[blockIdx].set(opr.slot);
+                        }
+                    }
+                };
+
+                for (unsigned opIdx = L.programStart[blockIdx]; opIdx < L.programStart[blockIdx + 1]; ++opIdx)
+                {
+                    const TransferOp &op = L.ops[opIdx];
+                    addRead(op.lhs);
+                    if (op.kind == TransferOp::Fold)
+                    {
+                        addRead(op.rhs);
+                    }
+                    if (op.kind != TransferOp::BranchTest && !written.test(op.dst))
+                    {
+                        written.set(op.dst);
+                        L.writes[blockIdx].push_back(op.dst);
+                    }
+                }
+
+                BitVector &touched = L.scratchBits;
+                touched = L.reads[blockIdx];
+                touched |= written;
+                for (unsigned slot : touched.set_bits())
+                {
+                    L.footprint[blockIdx].push_back(slot);
+                }
+            }
+        }
 
-        // Extracts the register name from an instruction
-        std::string getRegisterNameFromInstruction(const llvm::Instruction &ins)
+        // Computes which slots are live into and out of every block, and what each block stores back
+        void computeLiveness(FunctionLattice &L)
         {
-            std::string instrStr;
-            llvm::raw_string_ostream rso(instrStr);
-            ins.print(rso);
-            rso.flush();
-            std::string lhsRegisterName;
-            std::istringstream stream(instrStr);
-            stream >> lhsRegisterName;
-            return lhsRegisterName;
+            unsigned numSlots = L.slotValues.size();
+            unsigned numBlocks = L.blocks.size();
+            resetBitVectors(L.liveIn, numBlocks, numSlots);
+            resetBitVectors(L.liveOut, numBlocks, numSlots);
+
+            // Backward dataflow, visiting blocks in post-order
+            bool changed = true;
+            while (changed)
+            {
+                changed = false;
+                for (unsigned blockIdx = numBlocks; blockIdx-- > 0;)
+                {
+                    BitVector &liveOut = L.liveOut[blockIdx];
+                    for (auto *succ : successors(L.blocks[blockIdx]))
+                    {
+                        liveOut |= L.liveIn[L.blockNum[succ]];
+                    }
+                    BitVector &liveIn = L.scratchBits;
+                    liveIn = liveOut;
+                    liveIn.reset(L.written[blockIdx]);
+                    liveIn |= L.exposed[blockIdx];
+                    if (liveIn != L.liveIn[blockIdx])
+                    {
+                        std::swap(L.liveIn[blockIdx], liveIn);
+                        changed = true;
+                    }
+                }
+            }
+
+            resetLists(L.storeBack, numBlocks);
+            resetLists(L.killed, numBlocks);
+            for (unsigned blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+            {
+                for (unsigned slot : L.writes[blockIdx])
+                {
+                    if (L.liveOut[blockIdx].test(slot))
+                    {
+                        L.storeBack[blockIdx].push_back(slot);
+                    }
+                }
+                BitVector &dying = L.scratchBits;
+                dying = L.liveIn[blockIdx];
+                dying.reset(L.liveOut[blockIdx]);
+                dying.reset(L.written[blockIdx]);
+                for (unsigned slot : dying.set_bits())
+                {
+                    L.killed[blockIdx].push_back(slot);
+                }
+            }
         }
 
-        // Extracts the register name from a value
-        std::string getRegisterNameFromValue(Value *valueIns)
+        // Reads an operand from a state
+        LatticeCell operandVal(const TransferOperand &opr, const vector<LatticeCell> &state)
         {
-            std::string registerName;
-            llvm::raw_string_ostream rso(registerName);
-            valueIns->printAsOperand(rso, false);
-            rso.flush();
-            return registerName;
+            return opr.slot == TransferOperand::NoSlot ? opr.constVal : state[opr.slot];
         }
 
-        // Outputs the final results of constant propagation
-        void printFinalOutput(map<string, int> &insToVal, map<string, int> &insToLine, map<int, int> &lineToConstantVal)
+        // Runs a block's transfer program on the scratch array, starting from the block's IN state
+        void runBlock(unsigned blockIdx, FunctionLattice &L)
         {
-            map<int, int> lineToVal;
-            for (auto &mp1 : insToVal)
+            vector<LatticeCell> &state = L.scratch;
+            for (unsigned slot : L.footprint[blockIdx])
             {
-                lineToVal[insToLine[mp1.first]] = mp1.second;
+                state[slot] = L.store.get(L.IN[blockIdx], slot);
             }
-            for (auto &mp2 : lineToVal)
+
+            const TransferOp *op = L.ops.data() + L.programStart[blockIdx];
+            const TransferOp *end = L.ops.data() + L.programStart[blockIdx + 1];
+            for (; op != end; ++op)
             {
-                if (mp2.second != INT_MIN && mp2.second != INT_MAX)
+                switch (op->kind)
                 {
-                    lineToConstantVal[mp2.first] = mp2.second;
+                case TransferOp::StoreConst:
+                    state[op->dst] = op->lhs.constVal;
+                    break;
+                case TransferOp::Copy:
+                    state[op->dst] = state[op->lhs.slot];
+                    break;
+                case TransferOp::Fold:
+                    state[op->dst] = foldOp(*op, operandVal(op->lhs, state), operandVal(op->rhs, state), L.pool);
+                    break;
+                case TransferOp::BranchTest:
+                    L.condVal[blockIdx] = operandVal(op->lhs, state);
+                    break;
                 }
             }
         }
 
-        // Checks if an instruction is not compare, store, or alloca
-        bool isNotCompareStoreAlloca(llvm::Instruction &inst)
+        // Runs the block's instructions and writes the results that are live out into an OUT state;
+        // changed slots are appended to changedOut when it is given
+        void transferInto(unsigned blockIdx, LatticeStore::Node *&outState, FunctionLattice &L,
+                          vector<unsigned> *changedOut)
         {
-            return !isa<ICmpInst>(&inst) && !isa<FCmpInst>(&inst) && !isa<StoreInst>(&inst) && !isa<AllocaInst>(&inst);
+            runBlock(blockIdx, L);
+            for (unsigned slot : L.storeBack[blockIdx])
+            {
+                if (L.store.get(outState, slot) != L.scratch[slot])
+                {
+                    L.store.set(outState, slot, L.scratch[slot]);
+                    if (changedOut)
+                    {
+                        changedOut->push_back(slot);
+                    }
+                }
+            }
         }
 
-        // Compares two maps to check for equality
-        bool compareMaps(const map<string, int> &map1, const map<string, int> &map2)
+        // Checks if the branch condition recorded for a visited block lets control reach a successor
+        bool isFeasibleEdge(unsigned blockIdx, unsigned succNo, FunctionLattice &L)
         {
-            return map1 == map2;
+            auto *brInst = dyn_cast<BranchInst>(L.blocks[blockIdx]->getTerminator());
+            if (!brInst || !brInst->isConditional())
+            {
+                return true;
+            }
+            LatticeCell condVal = L.condVal[blockIdx];
+            return (condVal != LatticeCell::fromBool(true) || succNo == 0) && (condVal != LatticeCell::fromBool(false) || succNo == 1);
         }
 
-        bool runOnFunction(Function &F) override
+        // Checks if control can flow from a visited predecessor into a block; only those edges take part in the meet
+        bool isFeasiblePred(unsigned predIdx, BasicBlock *block, FunctionLattice &L)
+        {
+            if (!L.visited.test(predIdx))
+            {
+                return false;
+            }
+            Instruction *terminator = L.blocks[predIdx]->getTerminator();
+            for (unsigned succNo = 0; succNo < terminator->getNumSuccessors(); ++succNo)
+            {
+                if (terminator->getSuccessor(succNo) == block && isFeasibleEdge(predIdx, succNo, L))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Visits a block by meeting and transferring the whole state; returns true if OUT changed
+        bool visitBlockDense(BasicBlock *block, FunctionLattice &L)
         {
-            std::map<BasicBlock *, std::map<string, int>> IN, OUT;
-            map<string, int> insToLine;
-            map<int, Instruction *> lineToIns;
-            std::map<string, int> outM;
-            int line = 0;
+            unsigned blockIdx = L.blockNum[block];
 
-            // Initialize instruction-to-line mappings and OUT map
-            for (auto &BB : F)
+            // Perform the meet operation for predecessor blocks
+            for (auto predBB : predecessors(block))
             {
-                for (auto &ins : BB)
+                if (isFeasiblePred(L.blockNum[predBB], block, L))
                 {
-                    ++line;
-                    std::string lhsRegisterName = getRegisterNameFromInstruction(ins);
-                    if (insToLine.find(lhsRegisterName) == insToLine.end())
-                    {
-                        insToLine[lhsRegisterName] = line;
-                        lineToIns[line] = &ins;
-                    }
+                    L.store.meetInto(L.IN[blockIdx], L.OUT[L.blockNum[predBB]], L.liveIn[blockIdx].getData());
+                }
+            }
+
+            // OUT starts out sharing all of IN; only the written slots and the slots dying here get copied
+            LatticeStore::Node *outState = L.store.retain(L.IN[blockIdx]);
+            transferInto(blockIdx, outState, L, nullptr);
+            for (unsigned slot : L.killed[blockIdx])
+            {
+                L.store.set(outState, slot, LatticeCell::undef());
+            }
 
-                    if (isa<LoadInst>(&ins) || isa<AllocaInst>(ins) || isa<BinaryOperator>(ins) || isa<ICmpInst>(&ins))
+            if (L.store.equal(L.OUT[blockIdx], outState))
+            {
+                L.store.release(outState);
+                return false;
+            }
+            L.store.release(L.OUT[blockIdx]);
+            L.OUT[blockIdx] = outState;
+            return true;
+        }
+
+        // Visits a block touching only the slots changed since its last visit; returns the changed OUT slots
+        void visitBlockSparse(BasicBlock *block, FunctionLattice &L, vector<unsigned> &changedOut)
+        {
+            unsigned blockIdx = L.blockNum[block];
+
+            // Meet only the pending slots, keeping those whose IN value actually moved
+            bool rerun = false;
+            vector<unsigned> &changedIn = L.changedIn;
+            changedIn.clear();
+            for (unsigned slot : L.pendingSlots[blockIdx])
+            {
+                if (!L.liveIn[blockIdx].test(slot))
+                {
+                    continue;
+                }
+                LatticeCell oldVal = L.store.get(L.IN[blockIdx], slot);
+                LatticeCell newVal = oldVal;
+                for (auto predBB : predecessors(block))
+                {
+                    if (isFeasiblePred(L.blockNum[predBB], block, L))
                     {
-                        outM[lhsRegisterName] = INT_MAX;
+                        newVal = meetCells(newVal, L.store.get(L.OUT[L.blockNum[predBB]], slot));
                     }
                 }
+                if (newVal != oldVal)
+                {
+                    L.store.set(L.IN[blockIdx], slot, newVal);
+                    changedIn.push_back(slot);
+                    rerun |= L.reads[blockIdx].test(slot);
+                }
             }
+            L.pendingSlots[blockIdx].clear();
+            L.pending[blockIdx].reset();
 
-            // Initialize IN and OUT maps for all blocks
-            for (auto &BB : F)
+            // Slots the block does not write pass straight through to OUT
+            for (unsigned slot : changedIn)
             {
-                OUT[&BB] = outM;
-                IN[&BB] = outM;
+                LatticeCell inVal = L.store.get(L.IN[blockIdx], slot);
+                if (L.liveOut[blockIdx].test(slot) && !L.written[blockIdx].test(slot) &&
+                    L.store.get(L.OUT[blockIdx], slot) != inVal)
+                {
+                    L.store.set(L.OUT[blockIdx], slot, inVal);
+                    changedOut.push_back(slot);
+                }
             }
 
-            // Set the IN map for the entry block to INT_MIN
-            BasicBlock &startBlock = F.getEntryBlock();
-            for (auto &mp : OUT[&startBlock])
+            // Re-run the instructions only when a slot they read has changed
+            if (rerun)
             {
-                IN[&startBlock][mp.first] = INT_MIN;
+                transferInto(blockIdx, L.OUT[blockIdx], L, &changedOut);
             }
+        }
 
-            queue<BasicBlock *> q;
-            q.push(&startBlock);
+        // Visits a block with the dense or sparse mode and hands changed slots to the successors;
+        // returns true if the successors need to see the block again
+        bool visitBlock(unsigned blockIdx, FunctionLattice &L)
+        {
+            BasicBlock *block = L.blocks[blockIdx];
+            vector<unsigned> &changedOut = L.changedOut;
+            ++L.blockVisits;
 
-            // Worklist algorithm
-            while (!q.empty())
+            bool changed;
+            LatticeCell oldCondVal = L.condVal[blockIdx];
+            bool firstVisit = !L.visited.test(blockIdx);
+            L.visited.set(blockIdx);
+            if (SparseMode && !firstVisit)
+            {
+                changedOut.clear();
+                visitBlockSparse(block, L, changedOut);
+                changed = !changedOut.empty();
+            }
+            else
             {
-                BasicBlock *block = q.front();
-                q.pop();
+                changed = visitBlockDense(block, L);
+            }
 
-                map<string, int> inMapTemp = IN[block];
+            // The branch condition is usually dead at block exit, so a first visit or a new condition value
+            // must reach the successors too
+            bool condChanged = L.condVal[blockIdx] != oldCondVal;
+            if (SparseMode && (firstVisit || condChanged))
+            {
+                // A dense visit saw every slot and a new condition may open an edge, so every live-out slot
+                // may have changed for the successors
+                L.pendingSlots[blockIdx].clear();
+                L.pending[blockIdx].reset();
+                changedOut.clear();
+                for (unsigned slot : L.liveOut[blockIdx].set_bits())
+                {
+                    changedOut.push_back(slot);
+                }
+            }
+            changed |= firstVisit || condChanged;
 
-                // Perform the meet operation for predecessor blocks
-                for (auto predBB : predecessors(block))
+            // Hand the changed slots to every successor, feasible or not, so later meets see them
+            if (SparseMode && changed)
+            {
+                for (auto *succ : successors(block))
                 {
-                    for (auto &mp : OUT[predBB])
+                    unsigned succIdx = L.blockNum[succ];
+                    for (unsigned slot : changedOut)
                     {
-                        if (mp.second == INT_MIN || inMapTemp[mp.first] == INT_MIN)
-                        {
-                            inMapTemp[mp.first] = INT_MIN;
-                        }
-                        else if (inMapTemp[mp.first] == INT_MAX)
+                        if (!L.pending[succIdx].test(slot))
                         {
-                            inMapTemp[mp.first] = mp.second;
+                            L.pending[succIdx].set(slot);
+                            L.pendingSlots[succIdx].push_back(slot);
                         }
-                        else if (mp.second != INT_MAX && inMapTemp[mp.first] != mp.second)
+                    }
+                }
+            }
+
+            if (DebugOutput)
+            {
+                printState("IN", *block, L.IN[blockIdx], L);
+                printState("OUT", *block, L.OUT[blockIdx], L);
+            }
+
+            return changed;
+        }
+
+        // Worklist algorithm
+        void solveWorklist(Function &F, FunctionLattice &L)
+        {
+            BlockWorklist &q = Worklist;
+            q.reset(L.blocks.size());
+            q.push(L.blockNum[&F.getEntryBlock()]);
+
+            while (!q.empty())
+            {
+                unsigned blockIdx = q.pop();
+
+                // Push the feasible successors only when the block changed
+                if (visitBlock(blockIdx, L))
+                {
+                    Instruction *terminator = L.blocks[blockIdx]->getTerminator();
+                    for (unsigned succNo = 0; succNo < terminator->getNumSuccessors(); ++succNo)
+                    {
+                        if (isFeasibleEdge(blockIdx, succNo, L))
                         {
-                            inMapTemp[mp.first] = INT_MIN;
+                            q.push(L.blockNum[terminator->getSuccessor(succNo)]);
                         }
                     }
                 }
+            }
+        }
 
-                IN[block] = inMapTemp;
-                map<string, int> outMapTemp = inMapTemp;
+        // Visits a block of the loop-nest solver if a feasible edge from a visited predecessor reaches it
+        void visitIfReachable(unsigned blockIdx, FunctionLattice &L)
+        {
+            bool reachable = blockIdx == 0;
+            for (auto *predBB : predecessors(L.blocks[blockIdx]))
+            {
+                reachable = reachable || isFeasiblePred(L.blockNum[predBB], L.blocks[blockIdx], L);
+            }
 
-                // Analyze instructions in the block
-                for (auto &ins : *block)
+            if (reachable && visitBlock(blockIdx, L))
+            {
+                L.lastChange[blockIdx] = ++L.changeClock;
+            }
+        }
+
+        // Solves the blocks of one loop nest level in reverse post-order; a nested loop is solved to its own
+        // fixed point where its header appears, so it acts as a single summarized node of this level
+        void solveRegion(Loop *region, ArrayRef<unsigned> regionBlocks, LoopInfo &LI, FunctionLattice &L)
+        {
+            for (unsigned blockIdx : regionBlocks)
+            {
+                Loop *loop = LI.getLoopFor(L.blocks[blockIdx]);
+                if (loop == region)
                 {
-                    std::string lhsRegisterName = getRegisterNameFromInstruction(ins);
+                    visitIfReachable(blockIdx, L);
+                }
+                else if (loop->getHeader() == L.blocks[blockIdx] && loop->getParentLoop() == region)
+                {
+                    solveLoop(loop, LI, L);
+                }
+            }
+        }
 
-                    if (auto *storeInst = dyn_cast<StoreInst>(&ins))
-                    {
-                        Value *value = storeInst->getValueOperand();
-                        auto *constValue = dyn_cast<ConstantInt>(value);
-                        Value *ptr = storeInst->getPointerOperand();
-                        std::string ptrName = getRegisterNameFromValue(ptr);
+        // Sweeps a loop body until no latch changes, at which point its header's IN is stable. A loop solved
+        // before is only re-entered when an entry edge's source changed since, as its fixed point depends on
+        // nothing else.
+        void solveLoop(Loop *loop, LoopInfo &LI, FunctionLattice &L)
+        {
+            BasicBlock *header = loop->getHeader();
+            unsigned headerIdx = L.blockNum[header];
+            FunctionLattice::LoopSummary &summary = L.loops[loop];
+            if (summary.solved)
+            {
+                bool entryChanged = false;
+                for (auto *predBB : predecessors(header))
+                {
+                    entryChanged |= !loop->contains(predBB) && L.lastChange[L.blockNum[predBB]] > summary.solvedAt;
+                }
+                if (!entryChanged)
+                {
+                    return;
+                }
+            }
+            ArrayRef<unsigned> bodyBlocks(L.loopBlocks.data() + summary.bodyStart, summary.bodyEnd - summary.bodyStart);
 
-                        if (constValue)
-                        {
-                            outMapTemp[ptrName] = constValue->getZExtValue();
-                        }
-                        else
-                        {
-                            std::string valueVarName = getRegisterNameFromValue(value);
-                            outMapTemp[ptrName] = outMapTemp[valueVarName];
-                        }
+            SmallVector<BasicBlock *, 4> latches;
+            loop->getLoopLatches(latches);
+
+            bool latchChanged = true;
+            while (latchChanged)
+            {
+                unsigned sweepStart = L.changeClock;
+                visitIfReachable(headerIdx, L);
+                if (!L.visited.test(headerIdx))
+                {
+                    break;
+                }
+                solveRegion(loop, bodyBlocks, LI, L);
+
+                latchChanged = false;
+                for (BasicBlock *latch : latches)
+                {
+                    latchChanged |= L.lastChange[L.blockNum[latch]] > sweepStart;
+                }
+            }
+
+            // The nested solves only look up existing entries, so the reference is still valid
+            summary.solved = true;
+            summary.solvedAt = L.changeClock;
+        }
+
+        // Records the sorted non-header blocks of a loop and its nested loops in the reused loop storage
+        void collectLoopBodies(Loop *loop, FunctionLattice &L)
+        {
+            FunctionLattice::LoopSummary summary;
+            summary.bodyStart = L.loopBlocks.size();
+            for (BasicBlock *BB : loop->blocks())
+            {
+                if (BB != loop->getHeader())
+                {
+                    L.loopBlocks.push_back(L.blockNum[BB]);
+                }
+            }
+            summary.bodyEnd = L.loopBlocks.size();
+            std::sort(L.loopBlocks.begin() + summary.bodyStart, L.loopBlocks.end());
+            summary.solvedAt = 0;
+            summary.solved = false;
+            L.loops[loop] = summary;
+
+            for (Loop *subLoop : loop->getSubLoops())
+            {
+                collectLoopBodies(subLoop, L);
+            }
+        }
+
+        // Elimination-style solver over the loop nest. Returns false for irreducible control flow, where
+        // some retreating edge does not enter a natural loop header, so the caller falls back to the worklist.
+        bool solveLoopNest(FunctionLattice &L)
+        {
+            LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+            for (unsigned blockIdx = 0; blockIdx < L.blocks.size(); ++blockIdx)
+            {
+                for (auto *succ : successors(L.blocks[blockIdx]))
+                {
+                    unsigned succIdx = L.blockNum[succ];
+                    Loop *loop = LI.getLoopFor(succ);
+                    if (succIdx <= blockIdx && (!loop || loop->getHeader() != succ || !loop->contains(L.blocks[blockIdx])))
+                    {
+                        return false;
                     }
-                    else if (auto *loadInst = dyn_cast<LoadInst>(&ins))
+                }
+            }
+
+            L.lastChange.assign(L.blocks.size(), 0);
+            for (Loop *loop : LI)
+            {
+                collectLoopBodies(loop, L);
+            }
+            vector<unsigned> &allBlocks = L.allBlocks;
+            allBlocks.resize(L.blocks.size());
+            std::iota(allBlocks.begin(), allBlocks.end(), 0);
+            solveRegion(nullptr, allBlocks, LI, L);
+            return true;
+        }
+
+        // Prints a block state by register name, only used for -cp-debug
+        void printState(const char *label, BasicBlock &BB, const LatticeStore::Node *state, FunctionLattice &L)
+        {
+            errs() << label << "[" << BB.getName() << "]:";
+            for (unsigned slot = 0; slot < L.slotValues.size(); ++slot)
+            {
+                LatticeCell val = L.store.get(state, slot);
+                errs() << " " << getRegisterNameFromValue(L.slotValues[slot]) << "=";
+                if (val.isUndef())
+                {
+                    errs() << "undef";
+                }
+                else if (val.isOverdefined())
+                {
+                    errs() << "nac";
+                }
+                else
+                {
+                    Type *type = slotType(slot, L);
+                    APInt bits = L.pool.decode(val, cellWidth(type));
+                    if (type->isFloatingPointTy())
                     {
-                        Value *ptr = loadInst->getPointerOperand();
-                        std::string rhsVarName = getRegisterNameFromValue(ptr);
-                        outMapTemp[lhsRegisterName] = outMapTemp[rhsVarName];
+                        SmallString<16> text;
+                        APFloat(type->getFltSemantics(), bits).toString(text);
+                        errs() << text;
                     }
-                    else if (ins.isBinaryOp())
+                    else
                     {
-                        Value *opr1 = ins.getOperand(0);
-                        Value *opr2 = ins.getOperand(1);
-                        std::string operand1 = getRegisterNameFromValue(opr1);
-                        std::string operand2 = getRegisterNameFromValue(opr2);
-
-                        int opr1Val = isa<ConstantInt>(opr1) ? cast<ConstantInt>(opr1)->getZExtValue() : outMapTemp[operand1];
-                        int opr2Val = isa<ConstantInt>(opr2) ? cast<ConstantInt>(opr2)->getZExtValue() : outMapTemp[operand2];
+                        errs() << bits;
+                    }
+                }
+            }
+            errs() << "\n";
+        }
 
-                        int computedVal = INT_MIN;
-                        if (opr1Val != INT_MIN && opr2Val != INT_MIN)
-                        {
-                            switch (ins.getOpcode())
-                            {
-                            case Instruction::Add:
-                                computedVal = opr1Val + opr2Val;
-                                break;
-                            case Instruction::Sub:
-                                computedVal = opr1Val - opr2Val;
-                                break;
-                            case Instruction::Mul:
-                                computedVal = opr1Val * opr2Val;
-                                break;
-                            case Instruction::SDiv:
-                                computedVal = (opr2Val != 0) ? opr1Val / opr2Val : INT_MIN;
-                                break;
-                            default:
-                                computedVal = INT_MIN;
-                            }
-                        }
+        // Checks if an instruction is not compare, store, or alloca
+        bool isNotCompareStoreAlloca(llvm::Instruction &inst)
+        {
+            return !isa<ICmpInst>(&inst) && !isa<FCmpInst>(&inst) && !isa<StoreInst>(&inst) && !isa<AllocaInst>(&inst);
+        }
 
-                        outMapTemp[lhsRegisterName] = computedVal;
-                    }
+        void getAnalysisUsage(AnalysisUsage &AU) const override
+        {
+            AU.addRequired<AAResultsWrapperPass>();
+            if (Solver == LoopNestSolver)
+            {
+                AU.addRequired<LoopInfoWrapperPass>();
+            }
+        }
 
-                    if (auto *cmpInst = dyn_cast<ICmpInst>(&ins))
-                    {
-                        Value *opr1 = cmpInst->getOperand(0);
-                        Value *opr2 = cmpInst->getOperand(1);
-                        std::string operand1 = getRegisterNameFromValue(opr1);
-                        std::string operand2 = getRegisterNameFromValue(opr2);
+        bool runOnFunction(Function &F) override
+        {
+            FunctionLattice &L = Lattice;
+            L.clear();
+            numberBlocks(F, L);
+            numberSlots(F, L);
+            numberMemoryCells(F, L);
+            compilePrograms(L, getAnalysis<AAResultsWrapperPass>().getAAResults());
+            computeFootprints(L);
+            computeLiveness(L);
+            L.condVal.assign(L.blocks.size(), LatticeCell::undef());
 
-                        int opr1Val = isa<ConstantInt>(opr1) ? cast<ConstantInt>(opr1)->getZExtValue() : outMapTemp[operand1];
-                        int opr2Val = isa<ConstantInt>(opr2) ? cast<ConstantInt>(opr2)->getZExtValue() : outMapTemp[operand2];
+            // Initialize IN and OUT maps for all blocks; they all share one undefined state
+            unsigned numSlots = L.slotValues.size();
+            L.store.reset(numSlots);
+            LatticeStore::Node *undefState = L.store.makeUniform(LatticeCell::undef());
+            L.IN.assign(L.blocks.size(), undefState);
+            L.OUT.assign(L.blocks.size(), undefState);
+            for (unsigned blockIdx = 0; blockIdx < 2 * L.blocks.size(); ++blockIdx)
+            {
+                L.store.retain(undefState);
+            }
+            L.store.release(undefState);
 
-                        if (opr1Val == INT_MIN || opr2Val == INT_MIN)
-                        {
-                            outMapTemp[lhsRegisterName] = 2;
-                        }
-                        else
-                        {
-                            outMapTemp[lhsRegisterName] = (opr1Val == opr2Val);
-                        }
-                    }
+            // Set the live slots of the entry block's IN map to overdefined
+            BasicBlock &startBlock = F.getEntryBlock();
+            unsigned startIdx = L.blockNum[&startBlock];
+            for (unsigned slot : L.liveIn[startIdx].set_bits())
+            {
+                L.store.set(L.IN[startIdx], slot, LatticeCell::overdefined());
+            }
 
-                    if (auto *brInst = dyn_cast<BranchInst>(&ins))
-                    {
-                        if (brInst->isConditional())
-                        {
-                            Value *cond = brInst->getCondition();
-                            std::string condVar = getRegisterNameFromValue(cond);
-                            int condVal = outMapTemp[condVar];
+            if (Solver != LoopNestSolver || !solveLoopNest(L))
+            {
+                solveWorklist(F, L);
+            }
 
-                            if (!compareMaps(OUT[block], outMapTemp))
-                            {
-                                if (condVal == 1)
-                                {
-                                    q.push(brInst->getSuccessor(0));
-                                }
-                                else if (condVal == 0)
-                                {
-                                    q.push(brInst->getSuccessor(1));
-                                }
-                                else
-                                {
-                                    q.push(brInst->getSuccessor(0));
-                                    q.push(brInst->getSuccessor(1));
-                                }
-                            }
-                        }
-                        else
-                        {
-                            if (!compareMaps(OUT[block], outMapTemp))
-                            {
-                                q.push(brInst->getSuccessor(0));
-                            }
-                        }
+            if (ReportStats)
+            {
+                errs() << "ConstantPropagation: " << F.getName() << ": visited " << L.blockVisits << " blocks ("
+                       << L.blocks.size() << " in function), peak lattice memory "
+                       << L.store.peakBytes() / 1024 << " KiB\n";
+            }
 
-                        OUT[block] = outMapTemp;
-                    }
+            // Re-run every reached block once on its final IN state to read each value where it is defined,
+            // since OUT only keeps the slots that are live out of the block
+            L.slotResult.assign(numSlots, LatticeCell::undef());
+            for (unsigned blockIdx : L.visited.set_bits())
+            {
+                runBlock(blockIdx, L);
+                for (unsigned slot : L.writes[blockIdx])
+                {
+                    L.slotResult[slot] = L.scratch[slot];
                 }
             }
 
-            // Replace constants in the instructions
-            map<int, int> lineToConstantVal;
-            for (auto &BB : F)
+            for (unsigned blockIdx = 0; blockIdx < L.blocks.size(); ++blockIdx)
             {
-                printFinalOutput(OUT[&BB], insToLine, lineToConstantVal);
+                L.store.release(L.IN[blockIdx]);
+                L.store.release(L.OUT[blockIdx]);
             }
 
-            for (auto &mp : lineToConstantVal)
+            // Replace constants in the instructions, walking the value slots in instruction order
+            for (unsigned slot = 0; slot < L.firstCellSlot; ++slot)
             {
-                Instruction *ins = lineToIns[mp.first];
-                if (isNotCompareStoreAlloca(*ins))
+                LatticeCell val = L.slotResult[slot];
+                auto *ins = cast<Instruction>(L.slotValues[slot]);
+                unsigned bitWidth = cellWidth(ins->getType());
+                if (val.isConstant() && bitWidth != 0 && isNotCompareStoreAlloca(*ins))
                 {
-                    Constant *constant = ConstantInt::get(ins->getType(), mp.second);
-                    ins->replaceAllUsesWith(constant);
+                    APInt bits = L.pool.decode(val, bitWidth);
+                    Type *type = ins->getType();
+                    ins->replaceAllUsesWith(type->isFloatingPointTy() ? ConstantFP::get(ins->getContext(), APFloat(type->getFltSemantics(), bits))
+                                                                      : ConstantInt::get(type, bits));
                     ins->eraseFromParent();
                 }
             }
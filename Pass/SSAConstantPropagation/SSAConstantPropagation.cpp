@@ -5,23 +5,162 @@
 #include "llvm/IR/Type.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/ConstantRange.h"
+#include "llvm/Support/KnownBits.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "ConstantFolding.h"
 #include <string>
 #include <sstream>
 #include <fstream>
 #include <map>
-#include <set>
-#include <queue>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <thread>
 
 using namespace llvm;
 using namespace std;
+using namespace lattice;
 
 #define DEBUG_TYPE "SSAConstantPropagation"
 
+static cl::opt<bool> ReportStats("sscp-report", cl::desc("Print per-function instruction evaluation counts"), cl::init(false));
+static cl::opt<unsigned> Threads("sscp-threads", cl::desc("Threads that drain the worklists; 1 runs the sequential engine"), cl::init(1));
+static cl::opt<unsigned> ParallelMinInsts("sscp-parallel-min-insts", cl::desc("Smallest function, in instructions, that the parallel engine solves"), cl::init(10000));
+static cl::opt<bool> RangeMode("sscp-ranges", cl::desc("Track a range of values for every integer instruction"), cl::init(false));
+static cl::opt<bool> KnownBitsMode("sscp-known-bits", cl::desc("Track the known zero and one bits of every integer instruction"), cl::init(false));
+static cl::opt<bool> EdgeFacts("sscp-edge-facts", cl::desc("Use the values that branch and switch edges establish in the code they dominate"), cl::init(true));
+static cl::opt<unsigned> WidenAfter("sscp-widen-after", cl::desc("Changes of a loop-header PHI's range before it is widened"), cl::init(3));
+
 namespace
 {
 
+    // Value that solver threads can share. Copying reads the value, so cells can live in vectors that
+    // are assigned between functions.
+    template <typename T>
+    struct AtomicCell
+    {
+        std::atomic<T> val;
+
+        AtomicCell(T init = T()) : val(init) {}
+        AtomicCell(const AtomicCell &other) : val(other.val.load(std::memory_order_relaxed)) {}
+        AtomicCell &operator=(const AtomicCell &other)
+        {
+            val.store(other.val.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+    };
+
+    // Packed bitset whose bits solver threads can set and clear concurrently
+    class AtomicBitset
+    {
+        vector<AtomicCell<uint64_t>> words;
+
+    public:
+        // Sizes the bitset to numBits cleared bits
+        void assign(unsigned numBits)
+        {
+            words.assign((numBits + 63) / 64, AtomicCell<uint64_t>(0));
+        }
+
+        bool test(unsigned idx) const
+        {
+            return (words[idx / 64].val.load() >> (idx % 64)) & 1;
+        }
+
+        // Sets a bit and returns whether it was already set
+        bool testAndSet(unsigned idx)
+        {
+            uint64_t mask = uint64_t(1) << (idx % 64);
+            return words[idx / 64].val.fetch_or(mask) & mask;
+        }
+
+        // Clears a bit and returns whether it was set
+        bool testAndReset(unsigned idx)
+        {
+            uint64_t mask = uint64_t(1) << (idx % 64);
+            return words[idx / 64].val.fetch_and(~mask) & mask;
+        }
+    };
+
+    // Chase-Lev work-stealing deque of task numbers with a power-of-two capacity. The owning
+    // thread pushes and pops at the bottom; other threads steal from the top.
+    class StealingDeque
+    {
+        std::atomic<int64_t> top{0}, bottom{0};
+        std::unique_ptr<std::atomic<unsigned>[]> tasks;
+        int64_t mask = -1;
+
+    public:
+        // Empties the deque for at least capacity tasks, keeping its storage if it is large enough
+        void reset(size_t capacity)
+        {
+            top = 0;
+            bottom = 0;
+            if (capacity <= size_t(mask + 1))
+            {
+                return;
+            }
+            size_t size = 1;
+            while (size < capacity)
+            {
+                size <<= 1;
+            }
+            tasks.reset(new std::atomic<unsigned>[size]);
+            mask = size - 1;
+        }
+
+        void push(unsigned task)
+        {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            tasks[b & mask].store(task, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_release);
+        }
+
+        bool pop(unsigned &task)
+        {
+            int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_relaxed);
+            if (t > b)
+            {
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+            task = tasks[b & mask].load(std::memory_order_relaxed);
+            if (t == b)
+            {
+                // The last task: whoever moves top first takes it
+                bool taken = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return taken;
+            }
+            return true;
+        }
+
+        bool steal(unsigned &task)
+        {
+            int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom.load(std::memory_order_acquire);
+            if (t >= b)
+            {
+                return false;
+            }
+            task = tasks[t & mask].load(std::memory_order_relaxed);
+            return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+    };
+
+    // Deque of the parallel engine's worker running on this thread
+    thread_local StealingDeque *LocalDeque = nullptr;
+
     struct SSAConstantPropagation : public FunctionPass
     {
 
@@ -41,316 +180,1338 @@ namespace
             return lhsRegisterName;
         }
 
-        // Checks if the destination block is reachable from the source block
-        bool visitPhiReachable(BasicBlock *source, BasicBlock *dest,
-                               std::map<std::pair<llvm::BasicBlock *, llvm::BasicBlock *>, bool> &ExecutableFlag,
-                               std::map<llvm::BasicBlock *, std::set<llvm::BasicBlock *>> &AdjacencyList,
-                               std::map<BasicBlock *, bool> Visited)
+        // Worklist of instructions that pops the lowest index first and holds each instruction at most
+        // once. Indices follow the reverse post-order of the blocks, so definitions outside a loop settle
+        // before their users and a loop body is re-evaluated in order.
+        class InstWorklist
         {
-            std::queue<BasicBlock *> q;
-            q.push(source);
+            vector<unsigned> heap;
+            BitVector queued;
 
-            while (!q.empty())
+        public:
+            // Empties the worklist for a function with numInsts instructions, keeping its storage
+            void reset(unsigned numInsts)
             {
-                BasicBlock *top = q.front();
-                q.pop();
-                if (top == dest)
-                {
-                    return true;
-                }
-                Visited[top] = true;
+                heap.clear();
+                queued.clear();
+                queued.resize(numInsts);
+            }
 
-                for (auto node : AdjacencyList[top])
+            void push(unsigned instIdx)
+            {
+                if (!queued.test(instIdx))
                 {
-                    if (ExecutableFlag[{top, node}] && !Visited[node])
-                    {
-                        q.push(node);
-                    }
+                    queued.set(instIdx);
+                    heap.push_back(instIdx);
+                    std::push_heap(heap.begin(), heap.end(), std::greater<unsigned>());
                 }
             }
-            return false;
-        }
 
-        // Retrieves the constant value for a PHI operand
-        int getPhiOperandVal(llvm::Value *Operand, BasicBlock *dest,
-                             std::map<std::pair<llvm::BasicBlock *, llvm::BasicBlock *>, bool> &ExecutableFlag,
-                             std::map<llvm::BasicBlock *, std::set<llvm::BasicBlock *>> &AdjacencyList,
-                             std::map<BasicBlock *, bool> Visited,
-                             std::map<Instruction *, int> &insConstantVal, Instruction *ins)
+            unsigned pop()
+            {
+                std::pop_heap(heap.begin(), heap.end(), std::greater<unsigned>());
+                unsigned instIdx = heap.back();
+                heap.pop_back();
+                queued.reset(instIdx);
+                return instIdx;
+            }
+
+            bool empty() const { return heap.empty(); }
+        };
+
+        // Flat snapshot of a function laid out in reverse post-order. Instructions, operands, users and
+        // block successors live in contiguous arrays, so propagation never walks the IR's use lists.
+        struct FunctionGraph
         {
-            if (auto *ConstInt = llvm::dyn_cast<llvm::ConstantInt>(Operand))
+            static const unsigned NoIndex = ~0u;
+
+            // An operand: another instruction, or a constant when inst is NoIndex. PHI operands also
+            // record the index of the edge from their incoming block, and an operand that an edge fact
+            // holds for records the fact. In range mode an operand also records the range that the compares
+            // of the edges dominating it allow.
+            struct Operand
             {
-                return ConstInt->getSExtValue();
+                unsigned inst;
+                LatticeCell constVal;
+                unsigned edge;
+                unsigned fact;
+                unsigned rangeFact;
+            };
+
+            // What an executable edge out of a branch or switch establishes about a value: that it equals
+            // a constant, or that it differs from it
+            struct EdgeFact
+            {
+                Constant *constant;
+                LatticeCell constVal;
+                bool equal;
+            };
+
+            // The instruction as the folding functions describe it
+            struct Node : OpInfo
+            {
+                bool definesValue = false;
+            };
+
+            vector<BasicBlock *> blocks;
+            DenseMap<BasicBlock *, unsigned> blockNum;
+
+            // Instructions of all blocks, block b owning insts[instStart[b]..instStart[b + 1])
+            vector<Instruction *> insts;
+            DenseMap<const Instruction *, unsigned> instNum;
+            vector<Node> nodes;
+            vector<unsigned> blockOf;
+            vector<unsigned> instStart;
+
+            // CSR adjacency: operands and users of each instruction, and successors of each block. Edge
+            // succStart[b] + n leads to the n-th successor of block b.
+            vector<Operand> operands;
+            vector<unsigned> operandStart;
+            vector<unsigned> users, userStart;
+            vector<unsigned> succs, succStart;
+
+            // Lattice cell of each instruction; a conditional branch holds its condition value. Cells
+            // are atomic so the parallel engine can lower them from several threads, and constants too
+            // wide to inline live in the pool.
+            vector<AtomicCell<uint64_t>> value;
+            ConstantPool pool;
+
+            // Range mode: the range of each integer instruction, empty until it is reached, and how often
+            // it grew. Blocks entered by an edge that does not go forward in the reverse post-order are
+            // loop headers, and their PHIs are widened.
+            vector<ConstantRange> ranges;
+            vector<unsigned> rangeChanges;
+            BitVector loopHeaders;
+
+            // Known-bits mode: the known zero and one bits of each integer instruction. A value not reached
+            // yet has every bit known both ways, which the join of common bits ignores.
+            vector<KnownBits> known;
+
+            // Facts of the edges that dominate some use of the value they describe, and the ranges those
+            // edges allow in range mode
+            vector<EdgeFact> facts;
+            vector<ConstantRange> rangeFacts;
+
+            // The flow worklist is drained front to back and cleared once empty, so it keeps its storage.
+            // An edge is marked executable when it is queued, so it is queued at most once.
+            vector<unsigned> FlowWorkList;
+            InstWorklist SSAWorkList;
+            AtomicBitset ExecutableEdges;
+            vector<AtomicCell<unsigned>> nodeVisits;
+
+            // Number of times each instruction was evaluated
+            vector<AtomicCell<unsigned>> evaluations;
+
+            // Parallel engine: one deque per worker, the number of tasks queued or running, and the
+            // instructions queued in any deque. Tasks below insts.size() are instructions, the others
+            // are edges offset by insts.size(). The deques and the thread list outlive the function.
+            bool parallel = false;
+            vector<std::unique_ptr<StealingDeque>> deques;
+            vector<std::thread> workers;
+            std::atomic<int64_t> pendingTasks{0};
+            AtomicBitset queuedInsts;
+
+            // Scratch storage of buildGraph and collectEdgeFacts
+            vector<std::pair<BasicBlock *, unsigned>> dfsStack;
+            vector<unsigned> userFill;
+            DenseMap<BasicBlock *, unsigned> casesTo;
+
+            // Empties every container but keeps its storage for the next function
+            void clear()
+            {
+                blocks.clear();
+                blockNum.clear();
+                insts.clear();
+                instNum.clear();
+                nodes.clear();
+                blockOf.clear();
+                instStart.clear();
+                operands.clear();
+                operandStart.clear();
+                users.clear();
+                userStart.clear();
+                succs.clear();
+                succStart.clear();
+                value.clear();
+                ranges.clear();
+                known.clear();
+                facts.clear();
+                rangeFacts.clear();
+                loopHeaders.clear();
+                FlowWorkList.clear();
+                nodeVisits.clear();
             }
 
-            if (auto *DefiningInst = llvm::dyn_cast<llvm::Instruction>(Operand))
+            ArrayRef<Operand> operandsOf(unsigned inst) const
             {
-                llvm::BasicBlock *source = DefiningInst->getParent();
-                if (visitPhiReachable(source, dest, ExecutableFlag, AdjacencyList, Visited))
-                {
-                    return insConstantVal[llvm::dyn_cast<llvm::Instruction>(Operand)];
-                }
+                return makeArrayRef(operands).slice(operandStart[inst], operandStart[inst + 1] - operandStart[inst]);
             }
 
-            return INT_MAX;
-        }
+            ArrayRef<unsigned> usersOf(unsigned inst) const
+            {
+                return makeArrayRef(users).slice(userStart[inst], userStart[inst + 1] - userStart[inst]);
+            }
 
-        // Computes the meet value for SSA constants
-        int computeMeetValue(int Operand1Val, int Operand2Val)
+            ArrayRef<unsigned> successorsOf(unsigned block) const
+            {
+                return makeArrayRef(succs).slice(succStart[block], succStart[block + 1] - succStart[block]);
+            }
+        };
+
+        // Graph storage reused by every runOnFunction call
+        FunctionGraph Graph;
+
+        // Numbers the blocks in reverse post-order, unreachable blocks last. The depth-first search keeps
+        // its stack in the graph instead of allocating a traversal per function.
+        void numberBlocks(Function &F, FunctionGraph &G)
         {
-            if (Operand1Val == INT_MIN || Operand2Val == INT_MIN)
+            BasicBlock *entry = &F.getEntryBlock();
+            G.blockNum[entry] = 0;
+            G.dfsStack.push_back({entry, 0});
+            while (!G.dfsStack.empty())
             {
-                return INT_MIN;
+                BasicBlock *BB = G.dfsStack.back().first;
+                unsigned succNo = G.dfsStack.back().second++;
+                Instruction *terminator = BB->getTerminator();
+                if (succNo < terminator->getNumSuccessors())
+                {
+                    BasicBlock *succ = terminator->getSuccessor(succNo);
+                    if (G.blockNum.insert({succ, 0}).second)
+                    {
+                        G.dfsStack.push_back({succ, 0});
+                    }
+                }
+                else
+                {
+                    G.blocks.push_back(BB);
+                    G.dfsStack.pop_back();
+                }
             }
-            else if (Operand1Val == INT_MAX)
+            std::reverse(G.blocks.begin(), G.blocks.end());
+            for (unsigned blockIdx = 0; blockIdx < G.blocks.size(); ++blockIdx)
             {
-                return Operand2Val;
+                G.blockNum[G.blocks[blockIdx]] = blockIdx;
             }
-            else if (Operand2Val != INT_MAX && Operand1Val != Operand2Val)
+
+            for (auto &BB : F)
             {
-                return INT_MIN;
+                if (G.blockNum.insert({&BB, G.blocks.size()}).second)
+                {
+                    G.blocks.push_back(&BB);
+                }
             }
-            return Operand1Val;
         }
 
-        // Evaluates expressions and updates the constant values
-        int visitExpression(BasicBlock *block,
-                            std::map<Instruction *, int> &insConstantValue,
-                            std::queue<std::pair<Instruction *, Instruction *>> &SSAWorkList,
-                            std::queue<std::pair<llvm::BasicBlock *, llvm::BasicBlock *>> &FlowWorkList)
+        // Lays the function out as a FunctionGraph
+        void buildGraph(Function &F, FunctionGraph &G)
         {
-            int condition = 0;
+            G.clear();
+            numberBlocks(F, G);
 
-            for (auto &ins : *block)
+            DenseMap<const Instruction *, unsigned> &instNum = G.instNum;
+            for (unsigned blockIdx = 0; blockIdx < G.blocks.size(); ++blockIdx)
             {
-                if (ins.isBinaryOp())
+                G.instStart.push_back(G.insts.size());
+                for (auto &ins : *G.blocks[blockIdx])
                 {
-                    // Process binary operations
-                    Value *opr1 = ins.getOperand(0);
-                    Value *opr2 = ins.getOperand(1);
-                    auto *binaryInst = cast<BinaryOperator>(&ins);
-                    int opr1Val, opr2Val;
+                    instNum[&ins] = G.insts.size();
+                    G.insts.push_back(&ins);
+                    G.blockOf.push_back(blockIdx);
+                }
 
-                    opr1Val = (auto *operand1 = dyn_cast<ConstantInt>(opr1)) ? operand1->getZExtValue() : insConstantValue[dyn_cast<llvm::Instruction>(opr1)];
-                    opr2Val = (auto *operand2 = dyn_cast<ConstantInt>(opr2)) ? operand2->getZExtValue() : insConstantValue[dyn_cast<llvm::Instruction>(opr2)];
+                G.succStart.push_back(G.succs.size());
+                for (auto *succ : successors(G.blocks[blockIdx]))
+                {
+                    G.succs.push_back(G.blockNum[succ]);
+                }
+            }
+            G.instStart.push_back(G.insts.size());
+            G.succStart.push_back(G.succs.size());
 
-                    int computedVal = 0;
-                    switch (binaryInst->getOpcode())
+            // Operands; values that are neither constants nor instructions are not constant. The user
+            // counts are gathered in userStart, shifted by one for the prefix sum below.
+            unsigned numInsts = G.insts.size();
+            G.userStart.assign(numInsts + 1, 0);
+            G.pool.reset();
+            for (Instruction *ins : G.insts)
+            {
+                FunctionGraph::Node node;
+                static_cast<OpInfo &>(node) = describeOp(*ins);
+                node.definesValue = !ins->getType()->isVoidTy();
+                G.nodes.push_back(node);
+                G.operandStart.push_back(G.operands.size());
+                for (unsigned oprIdx = 0; oprIdx < ins->getNumOperands(); ++oprIdx)
+                {
+                    Value *opr = ins->getOperand(oprIdx);
+                    FunctionGraph::Operand operand = {FunctionGraph::NoIndex, LatticeCell::overdefined(), FunctionGraph::NoIndex, FunctionGraph::NoIndex, FunctionGraph::NoIndex};
+                    if (auto *constant = dyn_cast<Constant>(opr))
                     {
-                    case Instruction::Add:
-                        computedVal = opr1Val + opr2Val;
-                        break;
-                    case Instruction::Sub:
-                        computedVal = opr1Val - opr2Val;
-                        break;
-                    case Instruction::Mul:
-                        computedVal = opr1Val * opr2Val;
-                        break;
-                    case Instruction::SDiv:
-                        computedVal = (opr2Val != 0) ? opr1Val / opr2Val : 0;
-                        break;
-                    default:
-                        computedVal = 0;
+                        operand.constVal = constantCell(constant, G.pool);
                     }
-
-                    if (opr1Val == INT_MIN || opr2Val == INT_MIN)
+                    else if (auto *defInst = dyn_cast<Instruction>(opr))
                     {
-                        computedVal = INT_MIN;
+                        operand.inst = instNum.lookup(defInst);
+                        ++G.userStart[operand.inst + 1];
                     }
-
-                    if (insConstantValue[&ins] != computedVal)
+                    if (auto *phi = dyn_cast<PHINode>(ins))
                     {
-                        insConstantValue[&ins] = computedVal;
-                        for (auto *user : ins.users())
-                        {
-                            auto *userInstr = llvm::dyn_cast<llvm::Instruction>(user);
-                            SSAWorkList.push({&ins, userInstr});
-                        }
+                        unsigned predIdx = G.blockNum[phi->getIncomingBlock(oprIdx)];
+                        operand.edge = firstEdge(predIdx, G.blockNum[phi->getParent()], G);
                     }
+                    G.operands.push_back(operand);
                 }
-                else if (auto *cmpInst = dyn_cast<ICmpInst>(&ins))
+            }
+            G.operandStart.push_back(G.operands.size());
+
+            // An instruction's operands take at most one constant each, so solving adds at most one
+            // constant per instruction to the pool
+            G.pool.reserve(numInsts);
+
+            // Users, built from the operands by counting sort
+            for (unsigned instIdx = 0; instIdx < numInsts; ++instIdx)
+            {
+                G.userStart[instIdx + 1] += G.userStart[instIdx];
+            }
+            G.users.resize(G.userStart[numInsts]);
+            vector<unsigned> &fill = G.userFill;
+            fill.assign(G.userStart.begin(), G.userStart.end() - 1);
+            for (unsigned instIdx = 0; instIdx < numInsts; ++instIdx)
+            {
+                for (const auto &operand : G.operandsOf(instIdx))
                 {
-                    // Handle comparison instructions
-                    Value *opr1 = cmpInst->getOperand(0);
-                    Value *opr2 = cmpInst->getOperand(1);
+                    if (operand.inst != FunctionGraph::NoIndex)
+                    {
+                        G.users[fill[operand.inst]++] = instIdx;
+                    }
+                }
+            }
 
-                    int opr1Val = (auto *operand1 = dyn_cast<ConstantInt>(opr1)) ? operand1->getZExtValue() : insConstantValue[dyn_cast<llvm::Instruction>(opr1)];
-                    int opr2Val = (auto *operand2 = dyn_cast<ConstantInt>(opr2)) ? operand2->getZExtValue() : insConstantValue[dyn_cast<llvm::Instruction>(opr2)];
+            G.value.assign(numInsts, AtomicCell<uint64_t>(LatticeCell::UndefBits));
+            G.evaluations.assign(numInsts, AtomicCell<unsigned>(0));
+            G.SSAWorkList.reset(numInsts);
+            G.ExecutableEdges.assign(G.succs.size());
+            G.nodeVisits.assign(G.blocks.size(), AtomicCell<unsigned>(0));
 
-                    ICmpInst::Predicate predicate = cmpInst->getPredicate();
-                    if (opr1Val != INT_MIN && opr2Val != INT_MIN)
+            if (KnownBitsMode)
+            {
+                for (const auto &node : G.nodes)
+                {
+                    G.known.push_back(unreachedBits(hasIntegerDomains(node) ? node.bitWidth : 1));
+                }
+            }
+            if (RangeMode)
+            {
+                for (const auto &node : G.nodes)
+                {
+                    G.ranges.push_back(ConstantRange::getEmpty(hasIntegerDomains(node) ? node.bitWidth : 1));
+                }
+                G.rangeChanges.assign(numInsts, 0);
+                G.loopHeaders.resize(G.blocks.size());
+                for (unsigned blockIdx = 0; blockIdx < G.blocks.size(); ++blockIdx)
+                {
+                    for (unsigned succ : G.successorsOf(blockIdx))
                     {
-                        switch (predicate)
+                        if (succ <= blockIdx)
                         {
-                        case ICmpInst::ICMP_EQ:
-                            condition = (opr1Val == opr2Val);
-                            break;
-                        case ICmpInst::ICMP_NE:
-                            condition = (opr1Val != opr2Val);
-                            break;
-                        case ICmpInst::ICMP_SGT:
-                            condition = (opr1Val > opr2Val);
-                            break;
-                        case ICmpInst::ICMP_SLT:
-                            condition = (opr1Val < opr2Val);
-                            break;
-                        case ICmpInst::ICMP_SGE:
-                            condition = (opr1Val >= opr2Val);
-                            break;
-                        case ICmpInst::ICMP_SLE:
-                            condition = (opr1Val <= opr2Val);
-                            break;
-                        default:
-                            break;
+                            G.loopHeaders.set(succ);
                         }
                     }
-                    else
+                }
+            }
+        }
+
+        // Whether the range and known-bits modes track the instruction: integer values only, when either
+        // mode is on
+        static bool hasIntegerDomains(const FunctionGraph::Node &node)
+        {
+            return (RangeMode || KnownBitsMode) && node.bitWidth != 0 && !node.semantics;
+        }
+
+        // Known bits of a value that has not been reached: every bit known to be both zero and one
+        static KnownBits unreachedBits(unsigned bitWidth)
+        {
+            KnownBits known(bitWidth);
+            known.Zero.setAllBits();
+            known.One.setAllBits();
+            return known;
+        }
+
+        // Attaches a fact about value to every use that the edge from block to succ dominates. An equality
+        // fact replaces an inequality fact, and a fact nearer the use replaces a farther one of its kind.
+        void addEdgeFact(Value *value, BasicBlock *block, BasicBlock *succ, Constant *constant, bool equal, DominatorTree &DT, FunctionGraph &G)
+        {
+            LatticeCell constVal = constantCell(constant, G.pool);
+            if (!(isa<Instruction>(value) || isa<Argument>(value)) || !constVal.isConstant())
+            {
+                return;
+            }
+            unsigned factIdx = G.facts.size();
+            G.facts.push_back({constant, constVal, equal});
+
+            BasicBlockEdge edge(block, succ);
+            for (Use &use : value->uses())
+            {
+                auto *user = dyn_cast<Instruction>(use.getUser());
+                if (!user || !DT.dominates(edge, use))
+                {
+                    continue;
+                }
+                FunctionGraph::Operand &operand = G.operands[G.operandStart[G.instNum.lookup(user)] + use.getOperandNo()];
+                if (operand.fact != FunctionGraph::NoIndex)
+                {
+                    const FunctionGraph::EdgeFact &other = G.facts[operand.fact];
+                    if (other.equal && !equal)
                     {
-                        condition = 2; // Undefined condition
+                        continue;
                     }
                 }
-                else if (auto *branchInst = dyn_cast<BranchInst>(&ins))
+                operand.fact = factIdx;
+            }
+        }
+
+        // Attaches the range an edge allows for value to every use that the edge from block to succ dominates.
+        // Every such edge holds at the use, so a use that already has a range gets the intersection.
+        void addRangeFact(Value *value, BasicBlock *block, BasicBlock *succ, const ConstantRange &allowed, DominatorTree &DT, FunctionGraph &G)
+        {
+            if (!(isa<Instruction>(value) || isa<Argument>(value)))
+            {
+                return;
+            }
+            unsigned factIdx = G.rangeFacts.size();
+            G.rangeFacts.push_back(allowed);
+
+            BasicBlockEdge edge(block, succ);
+            for (Use &use : value->uses())
+            {
+                auto *user = dyn_cast<Instruction>(use.getUser());
+                if (!user || !DT.dominates(edge, use))
+                {
+                    continue;
+                }
+                FunctionGraph::Operand &operand = G.operands[G.operandStart[G.instNum.lookup(user)] + use.getOperandNo()];
+                if (operand.rangeFact == FunctionGraph::NoIndex)
                 {
-                    // Handle branch instructions
-                    if (branchInst->isConditional())
+                    operand.rangeFact = factIdx;
+                }
+                else
+                {
+                    ConstantRange both = G.rangeFacts[operand.rangeFact].intersectWith(allowed);
+                    operand.rangeFact = G.rangeFacts.size();
+                    G.rangeFacts.push_back(both);
+                }
+            }
+        }
+
+        // Collects the facts of the edges out of conditional branches and switches. A branch on a value
+        // makes it true on the first edge and false on the second; a branch on an icmp eq or ne of a value
+        // and a constant also makes the value equal to the constant on one edge and different on the
+        // other, and a switch makes its condition equal to the case value on the edge to a block that no
+        // other case and not the default reach. In range mode any other icmp of a value and an integer
+        // constant bounds the value on both edges. Blocks are visited in reverse post-order, so a nearer
+        // fact is attached after the facts that dominate it.
+        void collectEdgeFacts(DominatorTree &DT, FunctionGraph &G)
+        {
+            for (BasicBlock *BB : G.blocks)
+            {
+                Instruction *terminator = BB->getTerminator();
+                if (auto *branch = dyn_cast<BranchInst>(terminator))
+                {
+                    if (!branch->isConditional() || branch->getSuccessor(0) == branch->getSuccessor(1))
                     {
-                        if (condition == 1)
-                        {
-                            FlowWorkList.push({block, branchInst->getSuccessor(0)});
-                        }
-                        else if (condition == 0)
-                        {
-                            FlowWorkList.push({block, branchInst->getSuccessor(1)});
-                        }
-                        else
+                        continue;
+                    }
+                    Value *condition = branch->getCondition();
+                    LLVMContext &ctx = condition->getContext();
+                    addEdgeFact(condition, BB, branch->getSuccessor(0), ConstantInt::getTrue(ctx), true, DT, G);
+                    addEdgeFact(condition, BB, branch->getSuccessor(1), ConstantInt::getFalse(ctx), true, DT, G);
+
+                    auto *cmp = dyn_cast<ICmpInst>(condition);
+                    if (!cmp)
+                    {
+                        continue;
+                    }
+                    Value *value = cmp->getOperand(0);
+                    auto *constant = dyn_cast<Constant>(cmp->getOperand(1));
+                    CmpInst::Predicate predicate = cmp->getPredicate();
+                    if (!constant)
+                    {
+                        value = cmp->getOperand(1);
+                        constant = dyn_cast<Constant>(cmp->getOperand(0));
+                        predicate = cmp->getSwappedPredicate();
+                    }
+                    if (constant && cmp->isEquality())
+                    {
+                        bool eq = predicate == CmpInst::ICMP_EQ;
+                        addEdgeFact(value, BB, branch->getSuccessor(0), constant, eq, DT, G);
+                        addEdgeFact(value, BB, branch->getSuccessor(1), constant, !eq, DT, G);
+                    }
+                    else if (auto *bound = dyn_cast_or_null<ConstantInt>(constant))
+                    {
+                        if (RangeMode)
                         {
-                            FlowWorkList.push({block, branchInst->getSuccessor(0)});
-                            FlowWorkList.push({block, branchInst->getSuccessor(1)});
+                            const APInt &C = bound->getValue();
+                            addRangeFact(value, BB, branch->getSuccessor(0), ConstantRange::makeExactICmpRegion(predicate, C), DT, G);
+                            addRangeFact(value, BB, branch->getSuccessor(1), ConstantRange::makeExactICmpRegion(CmpInst::getInversePredicate(predicate), C), DT, G);
                         }
                     }
-                    else
+                }
+                else if (auto *sw = dyn_cast<SwitchInst>(terminator))
+                {
+                    DenseMap<BasicBlock *, unsigned> &casesTo = G.casesTo;
+                    casesTo.clear();
+                    for (auto &caseIt : sw->cases())
                     {
-                        FlowWorkList.push({block, branchInst->getSuccessor(0)});
+                        ++casesTo[caseIt.getCaseSuccessor()];
+                    }
+                    for (auto &caseIt : sw->cases())
+                    {
+                        BasicBlock *dest = caseIt.getCaseSuccessor();
+                        if (casesTo[dest] == 1 && dest != sw->getDefaultDest())
+                        {
+                            addEdgeFact(sw->getCondition(), BB, dest, caseIt.getCaseValue(), true, DT, G);
+                        }
                     }
                 }
             }
-            return 0;
         }
 
-        // Processes PHI nodes
-        void visitPhi(Instruction &ins, BasicBlock *destNode,
-                      std::map<std::pair<llvm::BasicBlock *, llvm::BasicBlock *>, bool> &ExecutableFlag,
-                      std::map<llvm::BasicBlock *, std::set<llvm::BasicBlock *>> &AdjacencyList,
-                      std::map<BasicBlock *, bool> Visited,
-                      std::map<Instruction *, int> &insConstantVal,
-                      std::queue<std::pair<Instruction *, Instruction *>> &SSAWorkList)
+        // Finds the first edge from one block to another; parallel edges to the same block share its index
+        unsigned firstEdge(unsigned block, unsigned succ, const FunctionGraph &G)
         {
-            auto *Phi = llvm::cast<llvm::PHINode>(&ins);
-            llvm::Value *Operand1 = Phi->getIncomingValue(0);
-            llvm::Value *Operand2 = Phi->getIncomingValue(1);
+            ArrayRef<unsigned> succs = G.successorsOf(block);
+            return G.succStart[block] + (std::find(succs.begin(), succs.end(), succ) - succs.begin());
+        }
 
-            int Operand1Val = getPhiOperandVal(Operand1, destNode, ExecutableFlag, AdjacencyList, Visited, insConstantVal, &ins);
-            int Operand2Val = getPhiOperandVal(Operand2, destNode, ExecutableFlag, AdjacencyList, Visited, insConstantVal, &ins);
-            int ComputedVal = computeMeetValue(Operand1Val, Operand2Val);
+        // Hands a task to the deque of the calling worker
+        void pushTask(unsigned task, FunctionGraph &G)
+        {
+            G.pendingTasks.fetch_add(1);
+            LocalDeque->push(task);
+        }
+
+        // Marks the edge from a block to its succNo-th successor executable and queues the visit it causes
+        void pushEdge(unsigned block, unsigned succNo, FunctionGraph &G)
+        {
+            unsigned edge = firstEdge(block, G.successorsOf(block)[succNo], G);
+            if (G.ExecutableEdges.testAndSet(edge))
+            {
+                return;
+            }
+            if (G.parallel)
+            {
+                pushTask(G.insts.size() + edge, G);
+            }
+            else
+            {
+                G.FlowWorkList.push_back(edge);
+            }
+        }
+
+        // Queues an instruction for re-evaluation
+        void pushUser(unsigned user, FunctionGraph &G)
+        {
+            if (!G.parallel)
+            {
+                G.SSAWorkList.push(user);
+            }
+            else if (!G.queuedInsts.testAndSet(user))
+            {
+                pushTask(user, G);
+            }
+        }
+
+        bool hasEqualityFact(const FunctionGraph::Operand &operand, const FunctionGraph &G)
+        {
+            return operand.fact != FunctionGraph::NoIndex && G.facts[operand.fact].equal;
+        }
 
-            if (insConstantVal[&ins] != ComputedVal)
+        // Retrieves the lattice cell of an operand; an equality fact of a dominating edge gives its constant
+        LatticeCell getOperandVal(const FunctionGraph::Operand &operand, FunctionGraph &G)
+        {
+            if (hasEqualityFact(operand, G))
             {
-                insConstantVal[&ins] = ComputedVal;
-                for (auto *user : ins.users())
+                return G.facts[operand.fact].constVal;
+            }
+            return operand.inst == FunctionGraph::NoIndex ? operand.constVal : LatticeCell{G.value[operand.inst].val.load()};
+        }
+
+        // Decides an icmp eq or ne of a value against the constant an inequality fact excludes for it
+        LatticeCell decideCompareByFacts(unsigned cmpIdx, FunctionGraph &G)
+        {
+            const FunctionGraph::Node &node = G.nodes[cmpIdx];
+            ArrayRef<FunctionGraph::Operand> operands = G.operandsOf(cmpIdx);
+            if (node.predicate != CmpInst::ICMP_EQ && node.predicate != CmpInst::ICMP_NE)
+            {
+                return LatticeCell::overdefined();
+            }
+            for (unsigned oprIdx = 0; oprIdx < 2; ++oprIdx)
+            {
+                unsigned fact = operands[oprIdx].fact;
+                if (fact != FunctionGraph::NoIndex && !G.facts[fact].equal &&
+                    getOperandVal(operands[1 - oprIdx], G) == G.facts[fact].constVal)
                 {
-                    auto *userInstr = llvm::dyn_cast<llvm::Instruction>(user);
-                    SSAWorkList.push({&ins, userInstr});
+                    return LatticeCell::fromBool(node.predicate == CmpInst::ICMP_NE);
                 }
             }
+            return LatticeCell::overdefined();
         }
 
-        // Main pass logic
-        bool runOnFunction(Function &F) override
+        // Retrieves the lattice cell of a PHI operand, ignoring operands whose incoming edge is not executable
+        LatticeCell getPhiOperandVal(unsigned phiIdx, unsigned incomingIdx, FunctionGraph &G)
         {
-            std::queue<std::pair<llvm::BasicBlock *, llvm::BasicBlock *>> FlowWorkList;
-            std::queue<std::pair<Instruction *, Instruction *>> SSAWorkList;
-            std::map<std::pair<llvm::BasicBlock *, llvm::BasicBlock *>, bool> ExecutableFlag;
-            std::map<llvm::BasicBlock *, int> nodeVisits;
-            std::map<llvm::BasicBlock *, std::set<llvm::BasicBlock *>> AdjacencyList;
-            std::map<llvm::BasicBlock *, bool> Visited;
-            std::map<Instruction *, int> insConstantVal;
+            const FunctionGraph::Operand &operand = G.operandsOf(phiIdx)[incomingIdx];
+            if (!G.ExecutableEdges.test(operand.edge))
+            {
+                return LatticeCell::undef();
+            }
+            return getOperandVal(operand, G);
+        }
 
-            // Initialize data structures
-            for (auto &BB : F)
+        // Lowers an instruction's cell to its meet with val and returns true if the cell changed. Cells only
+        // move down the lattice, so concurrent updates cannot undo each other, and since every transfer
+        // function is monotone both engines reach the same fixed point.
+        bool lowerValue(unsigned instIdx, LatticeCell val, FunctionGraph &G)
+        {
+            std::atomic<uint64_t> &cell = G.value[instIdx].val;
+            uint64_t oldBits = cell.load();
+            uint64_t newBits;
+            do
+            {
+                newBits = meetCells(LatticeCell{oldBits}, val).bits;
+                if (newBits == oldBits)
+                {
+                    return false;
+                }
+            } while (!cell.compare_exchange_weak(oldBits, newBits));
+            return true;
+        }
+
+        // Joins an instruction's range with range and returns true if the range grew. A loop-header PHI
+        // that keeps growing is widened to the signed bounds in the directions it grew, and any other
+        // range that keeps growing, which only irreducible flow allows, goes to the full set, so the
+        // ranges reach a fixed point.
+        bool widenRange(unsigned instIdx, const ConstantRange &range, FunctionGraph &G)
+        {
+            static const unsigned RangeChangeLimit = 64;
+            ConstantRange &current = G.ranges[instIdx];
+            ConstantRange joined = current.unionWith(range);
+            if (joined == current)
+            {
+                return false;
+            }
+
+            unsigned changes = ++G.rangeChanges[instIdx];
+            unsigned bitWidth = current.getBitWidth();
+            bool headerPhi = G.nodes[instIdx].opcode == Instruction::PHI && G.loopHeaders.test(G.blockOf[instIdx]);
+            if (headerPhi && changes > WidenAfter && !current.isEmptySet())
+            {
+                APInt lower = joined.getSignedMin(), upper = joined.getSignedMax();
+                if (lower.slt(current.getSignedMin()))
+                {
+                    lower = APInt::getSignedMinValue(bitWidth);
+                }
+                if (upper.sgt(current.getSignedMax()))
+                {
+                    upper = APInt::getSignedMaxValue(bitWidth);
+                }
+                joined = ConstantRange::getNonEmpty(lower, upper + 1);
+            }
+            else if (changes > RangeChangeLimit)
+            {
+                joined = ConstantRange::getFull(bitWidth);
+            }
+            current = joined;
+            return true;
+        }
+
+        // Joins an instruction's known bits with known and returns true if fewer bits are known. Bits only
+        // go from known to unknown, so no widening is needed.
+        bool joinKnownBits(unsigned instIdx, const KnownBits &known, FunctionGraph &G)
+        {
+            KnownBits joined = KnownBits::commonBits(G.known[instIdx], known);
+            if (joined.Zero == G.known[instIdx].Zero && joined.One == G.known[instIdx].One)
+            {
+                return false;
+            }
+            G.known[instIdx] = joined;
+            return true;
+        }
+
+        // Stores a new lattice value for an instruction and queues its users when the value changed, or when
+        // its range or known bits grew
+        void updateValue(unsigned instIdx, LatticeCell val, FunctionGraph &G, bool domainsGrew = false)
+        {
+            if (lowerValue(instIdx, val, G) || domainsGrew)
             {
-                for (auto &ins : BB)
+                for (unsigned user : G.usersOf(instIdx))
                 {
-                    insConstantVal[&ins] = INT_MAX;
+                    pushUser(user, G);
                 }
+            }
+        }
+
+        // Folds a select; a condition that is not constant meets both arms
+        LatticeCell evalSelect(LatticeCell condition, LatticeCell trueVal, LatticeCell falseVal)
+        {
+            if (condition.isUndef())
+            {
+                return LatticeCell::undef();
+            }
+            if (condition == LatticeCell::fromBool(true))
+            {
+                return trueVal;
+            }
+            if (condition == LatticeCell::fromBool(false))
+            {
+                return falseVal;
+            }
+            return meetCells(trueVal, falseVal);
+        }
 
-                for (auto *succ : successors(&BB))
+        // Known bits of a cell: none known while undefined or not constant, all of them for a constant
+        KnownBits cellKnownBits(LatticeCell val, unsigned bitWidth, FunctionGraph &G)
+        {
+            if (val.isUndef())
+            {
+                return unreachedBits(bitWidth);
+            }
+            if (val.isOverdefined())
+            {
+                return KnownBits(bitWidth);
+            }
+            return KnownBits::makeConstant(G.pool.decode(val, bitWidth));
+        }
+
+        // Retrieves the known bits of an integer operand
+        KnownBits getOperandKnownBits(const FunctionGraph::Operand &operand, unsigned bitWidth, FunctionGraph &G)
+        {
+            if (operand.inst == FunctionGraph::NoIndex || hasEqualityFact(operand, G))
+            {
+                return cellKnownBits(getOperandVal(operand, G), bitWidth, G);
+            }
+            return G.known[operand.inst];
+        }
+
+        // Decides an integer compare whose operands are not both constant from their known bits
+        LatticeCell decideCompareByBits(unsigned cmpIdx, FunctionGraph &G)
+        {
+            const FunctionGraph::Node &node = G.nodes[cmpIdx];
+            ArrayRef<FunctionGraph::Operand> operands = G.operandsOf(cmpIdx);
+            if (node.operandWidth == 0 || node.operandSemantics)
+            {
+                return LatticeCell::overdefined();
+            }
+            KnownBits lhs = getOperandKnownBits(operands[0], node.operandWidth, G);
+            KnownBits rhs = getOperandKnownBits(operands[1], node.operandWidth, G);
+            if (lhs.hasConflict() || rhs.hasConflict())
+            {
+                return LatticeCell::overdefined();
+            }
+
+            Optional<bool> decided;
+            switch (node.predicate)
+            {
+            case CmpInst::ICMP_EQ:
+                decided = KnownBits::eq(lhs, rhs);
+                break;
+            case CmpInst::ICMP_NE:
+                decided = KnownBits::ne(lhs, rhs);
+                break;
+            case CmpInst::ICMP_UGT:
+                decided = KnownBits::ugt(lhs, rhs);
+                break;
+            case CmpInst::ICMP_UGE:
+                decided = KnownBits::uge(lhs, rhs);
+                break;
+            case CmpInst::ICMP_ULT:
+                decided = KnownBits::ult(lhs, rhs);
+                break;
+            case CmpInst::ICMP_ULE:
+                decided = KnownBits::ule(lhs, rhs);
+                break;
+            case CmpInst::ICMP_SGT:
+                decided = KnownBits::sgt(lhs, rhs);
+                break;
+            case CmpInst::ICMP_SGE:
+                decided = KnownBits::sge(lhs, rhs);
+                break;
+            case CmpInst::ICMP_SLT:
+                decided = KnownBits::slt(lhs, rhs);
+                break;
+            case CmpInst::ICMP_SLE:
+                decided = KnownBits::sle(lhs, rhs);
+                break;
+            }
+            return decided ? LatticeCell::fromBool(*decided) : LatticeCell::overdefined();
+        }
+
+        // Known bits of a non-PHI integer instruction whose cell is val. A cell that is not constant takes
+        // the bits computed from the operands' known bits; other operations know no bits. An operand not
+        // reached yet leaves the result unreached, and a result with conflicting bits, which only a
+        // shift producing poison gives, knows no bits.
+        KnownBits evalKnownBits(unsigned instIdx, LatticeCell val, FunctionGraph &G)
+        {
+            const FunctionGraph::Node &node = G.nodes[instIdx];
+            ArrayRef<FunctionGraph::Operand> operands = G.operandsOf(instIdx);
+            unsigned bitWidth = node.bitWidth;
+            if (!val.isOverdefined())
+            {
+                return cellKnownBits(val, bitWidth, G);
+            }
+
+            if (node.opcode == Instruction::Select)
+            {
+                LatticeCell condition = getOperandVal(operands[0], G);
+                KnownBits trueBits = getOperandKnownBits(operands[1], bitWidth, G);
+                KnownBits falseBits = getOperandKnownBits(operands[2], bitWidth, G);
+                if (condition == LatticeCell::fromBool(true))
+                {
+                    return trueBits;
+                }
+                if (condition == LatticeCell::fromBool(false))
                 {
-                    AdjacencyList[&BB].insert(succ);
-                    ExecutableFlag[{&BB, succ}] = false;
+                    return falseBits;
                 }
+                return KnownBits::commonBits(trueBits, falseBits);
+            }
+
+            bool binary = Instruction::isBinaryOp(node.opcode);
+            bool cast = node.opcode == Instruction::Trunc || node.opcode == Instruction::ZExt || node.opcode == Instruction::SExt;
+            if (!binary && !cast)
+            {
+                return KnownBits(bitWidth);
+            }
+            KnownBits lhs = getOperandKnownBits(operands[0], node.operandWidth, G);
+            KnownBits rhs = binary ? getOperandKnownBits(operands[1], bitWidth, G) : KnownBits(bitWidth);
+            if (lhs.hasConflict() || rhs.hasConflict())
+            {
+                return unreachedBits(bitWidth);
+            }
+
+            KnownBits result(bitWidth);
+            switch (node.opcode)
+            {
+            case Instruction::And:
+                result = lhs & rhs;
+                break;
+            case Instruction::Or:
+                result = lhs | rhs;
+                break;
+            case Instruction::Xor:
+                result = lhs ^ rhs;
+                break;
+            case Instruction::Shl:
+                result = KnownBits::shl(lhs, rhs);
+                break;
+            case Instruction::LShr:
+                result = KnownBits::lshr(lhs, rhs);
+                break;
+            case Instruction::AShr:
+                result = KnownBits::ashr(lhs, rhs);
+                break;
+            case Instruction::Add:
+                result = KnownBits::computeForAddSub(true, node.noSignedWrap, lhs, rhs);
+                break;
+            case Instruction::Sub:
+                result = KnownBits::computeForAddSub(false, node.noSignedWrap, lhs, rhs);
+                break;
+            case Instruction::Mul:
+                result = KnownBits::mul(lhs, rhs);
+                break;
+            case Instruction::Trunc:
+                result = lhs.trunc(bitWidth);
+                break;
+            case Instruction::ZExt:
+                result = lhs.zext(bitWidth);
+                break;
+            case Instruction::SExt:
+                result = lhs.sext(bitWidth);
+                break;
+            }
+            return result.hasConflict() ? KnownBits(bitWidth) : result;
+        }
+
+        // Range of the values a cell stands for: none while undefined and all of them when not constant
+        ConstantRange cellRange(LatticeCell val, unsigned bitWidth, FunctionGraph &G)
+        {
+            if (val.isUndef())
+            {
+                return ConstantRange::getEmpty(bitWidth);
+            }
+            if (val.isOverdefined())
+            {
+                return ConstantRange::getFull(bitWidth);
+            }
+            return ConstantRange(G.pool.decode(val, bitWidth));
+        }
+
+        // Retrieves the range of an integer operand; an inequality fact removes its constant from the range,
+        // and the compares of dominating edges bound it
+        ConstantRange getOperandRange(const FunctionGraph::Operand &operand, unsigned bitWidth, FunctionGraph &G)
+        {
+            bool fromCell = operand.inst == FunctionGraph::NoIndex || hasEqualityFact(operand, G);
+            ConstantRange range = fromCell ? cellRange(getOperandVal(operand, G), bitWidth, G) : G.ranges[operand.inst];
+            if (operand.fact != FunctionGraph::NoIndex && !G.facts[operand.fact].equal)
+            {
+                range = range.difference(ConstantRange(G.pool.decode(G.facts[operand.fact].constVal, bitWidth)));
+            }
+            if (operand.rangeFact != FunctionGraph::NoIndex)
+            {
+                range = range.intersectWith(G.rangeFacts[operand.rangeFact]);
+            }
+            return range;
+        }
 
-                nodeVisits[&BB] = 0;
-                Visited[&BB] = false;
+        // Decides an integer compare whose operands are not both constant from their ranges
+        LatticeCell decideCompare(unsigned cmpIdx, FunctionGraph &G)
+        {
+            const FunctionGraph::Node &node = G.nodes[cmpIdx];
+            ArrayRef<FunctionGraph::Operand> operands = G.operandsOf(cmpIdx);
+            if (node.operandWidth == 0 || node.operandSemantics)
+            {
+                return LatticeCell::overdefined();
             }
+            ConstantRange lhs = getOperandRange(operands[0], node.operandWidth, G);
+            ConstantRange rhs = getOperandRange(operands[1], node.operandWidth, G);
+            if (lhs.isEmptySet() || rhs.isEmptySet())
+            {
+                return LatticeCell::overdefined();
+            }
+            auto predicate = static_cast<CmpInst::Predicate>(node.predicate);
+            if (lhs.icmp(predicate, rhs))
+            {
+                return LatticeCell::fromBool(true);
+            }
+            if (lhs.icmp(CmpInst::getInversePredicate(predicate), rhs))
+            {
+                return LatticeCell::fromBool(false);
+            }
+            return LatticeCell::overdefined();
+        }
 
-            FlowWorkList.push({nullptr, &F.getEntryBlock()});
+        // Range of a non-PHI integer instruction whose cell is val. A cell that is not constant takes the
+        // range computed from the operands' ranges; operations without a range transfer take every value.
+        ConstantRange evalRange(unsigned instIdx, LatticeCell val, FunctionGraph &G)
+        {
+            const FunctionGraph::Node &node = G.nodes[instIdx];
+            ArrayRef<FunctionGraph::Operand> operands = G.operandsOf(instIdx);
+            unsigned bitWidth = node.bitWidth;
+            if (!val.isOverdefined())
+            {
+                return cellRange(val, bitWidth, G);
+            }
 
-            // Process the worklists
-            while (!FlowWorkList.empty() || !SSAWorkList.empty())
+            if (node.opcode == Instruction::Select)
             {
-                while (!FlowWorkList.empty())
+                LatticeCell condition = getOperandVal(operands[0], G);
+                ConstantRange trueRange = getOperandRange(operands[1], bitWidth, G);
+                ConstantRange falseRange = getOperandRange(operands[2], bitWidth, G);
+                if (condition == LatticeCell::fromBool(true))
+                {
+                    return trueRange;
+                }
+                if (condition == LatticeCell::fromBool(false))
                 {
-                    auto edge = FlowWorkList.front();
-                    FlowWorkList.pop();
+                    return falseRange;
+                }
+                return trueRange.unionWith(falseRange);
+            }
+            if (Instruction::isBinaryOp(node.opcode))
+            {
+                unsigned noWrap = (node.noSignedWrap ? OverflowingBinaryOperator::NoSignedWrap : 0) |
+                                  (node.noUnsignedWrap ? OverflowingBinaryOperator::NoUnsignedWrap : 0);
+                ConstantRange lhs = getOperandRange(operands[0], bitWidth, G);
+                ConstantRange rhs = getOperandRange(operands[1], bitWidth, G);
+                return lhs.overflowingBinaryOp(static_cast<Instruction::BinaryOps>(node.opcode), rhs, noWrap);
+            }
+            if (node.opcode == Instruction::Trunc || node.opcode == Instruction::ZExt || node.opcode == Instruction::SExt)
+            {
+                return getOperandRange(operands[0], node.operandWidth, G).castOp(static_cast<Instruction::CastOps>(node.opcode), bitWidth);
+            }
+            return ConstantRange::getFull(bitWidth);
+        }
 
-                    if (!ExecutableFlag[edge])
-                    {
-                        ExecutableFlag[edge] = true;
-                        BasicBlock *destNode = edge.second;
-                        nodeVisits[destNode]++;
+        // Pushes the flow edges a conditional branch allows, only when its condition value changed
+        void visitBranch(unsigned branchIdx, FunctionGraph &G)
+        {
+            unsigned block = G.blockOf[branchIdx];
+            ArrayRef<FunctionGraph::Operand> operands = G.operandsOf(branchIdx);
+            if (G.successorsOf(block).size() == 1)
+            {
+                pushEdge(block, 0, G);
+                return;
+            }
 
-                        for (auto &ins : *destNode)
-                        {
-                            if (llvm::isa<llvm::PHINode>(&ins))
-                            {
-                                visitPhi(ins, destNode, ExecutableFlag, AdjacencyList, Visited, insConstantVal, SSAWorkList);
-                            }
-                        }
+            // Operand 0 of a conditional branch is its condition
+            if (!lowerValue(branchIdx, getOperandVal(operands[0], G), G))
+            {
+                return;
+            }
+            LatticeCell condition{G.value[branchIdx].val.load()};
 
-                        if (nodeVisits[destNode] == 1)
-                        {
-                            visitExpression(destNode, insConstantVal, SSAWorkList, FlowWorkList);
-                        }
-                    }
+            if (condition == LatticeCell::fromBool(true))
+            {
+                pushEdge(block, 0, G);
+            }
+            else if (condition == LatticeCell::fromBool(false))
+            {
+                pushEdge(block, 1, G);
+            }
+            else if (condition.isOverdefined())
+            {
+                pushEdge(block, 0, G);
+                pushEdge(block, 1, G);
+            }
+        }
+
+        // Evaluates a single non-PHI instruction and updates its constant value
+        void visitInstruction(unsigned instIdx, FunctionGraph &G)
+        {
+            const FunctionGraph::Node &node = G.nodes[instIdx];
+            ArrayRef<FunctionGraph::Operand> operands = G.operandsOf(instIdx);
+            LatticeCell val;
+            if (node.opcode == Instruction::Select)
+            {
+                val = evalSelect(getOperandVal(operands[0], G), getOperandVal(operands[1], G), getOperandVal(operands[2], G));
+            }
+            else if (node.opcode == Instruction::Br)
+            {
+                visitBranch(instIdx, G);
+                return;
+            }
+            else if (Instruction::isTerminator(node.opcode))
+            {
+                // Other terminators are not folded, so every successor is reachable. The value an invoke or
+                // callbr defines is not constant, like the value of a call, and takes every value in the
+                // range and known-bits domains below.
+                unsigned block = G.blockOf[instIdx];
+                for (unsigned succNo = 0; succNo < G.successorsOf(block).size(); ++succNo)
+                {
+                    pushEdge(block, succNo, G);
                 }
+                if (!node.definesValue)
+                {
+                    return;
+                }
+                val = LatticeCell::overdefined();
+            }
+            else if (node.definesValue)
+            {
+                // Everything else goes through the shared evaluator; what it cannot fold is not constant
+                LatticeCell opr1Val = operands.size() > 0 ? getOperandVal(operands[0], G) : LatticeCell::overdefined();
+                LatticeCell opr2Val = operands.size() > 1 ? getOperandVal(operands[1], G) : LatticeCell::undef();
+                val = foldOp(node, opr1Val, opr2Val, G.pool);
+            }
+            else
+            {
+                return;
+            }
 
-                while (!SSAWorkList.empty())
+            if (node.opcode == Instruction::ICmp && val.isOverdefined())
+            {
+                val = decideCompareByFacts(instIdx, G);
+            }
+            if (!hasIntegerDomains(node))
+            {
+                updateValue(instIdx, val, G);
+                return;
+            }
+
+            // Known-bits and range modes: a compare either decides and a value either pins down are constants
+            bool domainsGrew = false;
+            if (KnownBitsMode)
+            {
+                if (node.opcode == Instruction::ICmp && val.isOverdefined())
+                {
+                    val = decideCompareByBits(instIdx, G);
+                }
+                KnownBits known = evalKnownBits(instIdx, val, G);
+                if (val.isOverdefined() && known.isConstant())
+                {
+                    val = G.pool.encode(known.getConstant());
+                }
+                domainsGrew = joinKnownBits(instIdx, known, G);
+            }
+            if (RangeMode)
+            {
+                if (node.opcode == Instruction::ICmp && val.isOverdefined())
+                {
+                    val = decideCompare(instIdx, G);
+                }
+                ConstantRange range = evalRange(instIdx, val, G);
+                if (val.isOverdefined() && range.isSingleElement())
                 {
-                    auto edge = SSAWorkList.front();
-                    SSAWorkList.pop();
+                    val = G.pool.encode(*range.getSingleElement());
+                }
+                domainsGrew |= widenRange(instIdx, range, G);
+            }
+            updateValue(instIdx, val, G, domainsGrew);
+        }
 
-                    if (llvm::isa<llvm::PHINode>(edge.second))
+        // Processes PHI nodes by meeting every incoming value over an executable edge; the meet stops
+        // as soon as it is not constant
+        void visitPhi(unsigned phiIdx, FunctionGraph &G)
+        {
+            LatticeCell ComputedVal = LatticeCell::undef();
+            unsigned numIncoming = G.operandStart[phiIdx + 1] - G.operandStart[phiIdx];
+            for (unsigned incomingIdx = 0; incomingIdx < numIncoming && !ComputedVal.isOverdefined(); ++incomingIdx)
+            {
+                ComputedVal = meetCells(ComputedVal, getPhiOperandVal(phiIdx, incomingIdx, G));
+            }
+            if (!hasIntegerDomains(G.nodes[phiIdx]))
+            {
+                updateValue(phiIdx, ComputedVal, G);
+                return;
+            }
+
+            // Known-bits and range modes: the common bits and the union of the ranges flowing in over
+            // executable edges
+            unsigned bitWidth = G.nodes[phiIdx].bitWidth;
+            bool domainsGrew = false;
+            if (KnownBitsMode)
+            {
+                KnownBits known = unreachedBits(bitWidth);
+                for (const auto &operand : G.operandsOf(phiIdx))
+                {
+                    if (G.ExecutableEdges.test(operand.edge))
                     {
-                        visitPhi(*edge.second, edge.second->getParent(), ExecutableFlag, AdjacencyList, Visited, insConstantVal, SSAWorkList);
+                        known = KnownBits::commonBits(known, getOperandKnownBits(operand, bitWidth, G));
                     }
-                    else
+                }
+                domainsGrew = joinKnownBits(phiIdx, known, G);
+            }
+            if (RangeMode)
+            {
+                ConstantRange range = ConstantRange::getEmpty(bitWidth);
+                for (const auto &operand : G.operandsOf(phiIdx))
+                {
+                    if (G.ExecutableEdges.test(operand.edge))
                     {
-                        visitExpression(edge.second->getParent(), insConstantVal, SSAWorkList, FlowWorkList);
+                        range = range.unionWith(getOperandRange(operand, bitWidth, G));
                     }
                 }
+                domainsGrew |= widenRange(phiIdx, range, G);
             }
+            updateValue(phiIdx, ComputedVal, G, domainsGrew);
+        }
 
-            // Replace constants and remove redundant instructions
-            for (auto &entry : insConstantVal)
+        // Visits a block reached through a new executable edge. A new edge only changes the PHIs; the
+        // other instructions are evaluated on the first visit.
+        void visitBlock(unsigned block, FunctionGraph &G)
+        {
+            unsigned visits = ++G.nodeVisits[block].val;
+            for (unsigned instIdx = G.instStart[block]; instIdx < G.instStart[block + 1]; ++instIdx)
             {
-                Instruction *inst = entry.first;
-                int constVal = entry.second;
+                if (visits == 1 || G.nodes[instIdx].opcode == Instruction::PHI)
+                {
+                    evaluate(instIdx, G);
+                }
+            }
+        }
+
+        // Evaluates a PHI or any other instruction and counts the evaluation; the parallel engine may
+        // lose a count when two threads evaluate the same instruction at once
+        void evaluate(unsigned instIdx, FunctionGraph &G)
+        {
+            std::atomic<unsigned> &count = G.evaluations[instIdx].val;
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (G.nodes[instIdx].opcode == Instruction::PHI)
+            {
+                visitPhi(instIdx, G);
+            }
+            else
+            {
+                visitInstruction(instIdx, G);
+            }
+        }
+
+        // Prints how often the instructions were evaluated, only used for -sscp-report
+        void printStats(Function &F, FunctionGraph &G)
+        {
+            unsigned total = 0, mostIdx = 0;
+            for (unsigned instIdx = 0; instIdx < G.insts.size(); ++instIdx)
+            {
+                unsigned count = G.evaluations[instIdx].val.load();
+                total += count;
+                mostIdx = count > G.evaluations[mostIdx].val.load() ? instIdx : mostIdx;
+            }
+            errs() << "SSAConstantPropagation: " << F.getName() << ": " << total << " instruction evaluations ("
+                   << G.insts.size() << " instructions in function)";
+            if (total > 0)
+            {
+                errs() << ", most evaluated " << getRegisterNameFromInstruction(*G.insts[mostIdx]) << " ("
+                       << G.evaluations[mostIdx].val.load() << " times)";
+            }
+            errs() << "\n";
+        }
+
+        // Sequential engine: drains the flow worklist, then the SSA worklist, until both are empty
+        void solveSequential(unsigned entry, FunctionGraph &G)
+        {
+            visitBlock(entry, G);
+
+            while (!G.FlowWorkList.empty() || !G.SSAWorkList.empty())
+            {
+                for (size_t head = 0; head < G.FlowWorkList.size(); ++head)
+                {
+                    visitBlock(G.succs[G.FlowWorkList[head]], G);
+                }
+                G.FlowWorkList.clear();
 
-                if (constVal != INT_MIN && constVal != INT_MAX)
+                while (!G.SSAWorkList.empty())
                 {
-                    Constant *constant = ConstantInt::get(inst->getType(), constVal);
+                    // Only the user is re-evaluated, and only once its block has been reached
+                    unsigned user = G.SSAWorkList.pop();
+                    if (G.nodeVisits[G.blockOf[user]].val.load() != 0)
+                    {
+                        evaluate(user, G);
+                    }
+                }
+            }
+        }
+
+        // Runs one task of the parallel engine: an instruction to re-evaluate, or a block reached through a
+        // new edge
+        void runTask(unsigned task, FunctionGraph &G)
+        {
+            unsigned numInsts = G.insts.size();
+            if (task >= numInsts)
+            {
+                visitBlock(G.succs[task - numInsts], G);
+                return;
+            }
+
+            // The flag is cleared first, so a change during the evaluation queues the instruction again
+            G.queuedInsts.testAndReset(task);
+            if (G.nodeVisits[G.blockOf[task]].val.load() != 0)
+            {
+                evaluate(task, G);
+            }
+        }
+
+        // Runs tasks from the worker's own deque and steals from the others when it is empty, until no
+        // task is queued or running anywhere
+        void runWorker(unsigned workerIdx, unsigned numWorkers, FunctionGraph &G)
+        {
+            LocalDeque = G.deques[workerIdx].get();
+            unsigned task;
+            for (;;)
+            {
+                bool found = LocalDeque->pop(task);
+                for (unsigned offset = 1; !found && offset < numWorkers; ++offset)
+                {
+                    found = G.deques[(workerIdx + offset) % numWorkers]->steal(task);
+                }
+
+                if (found)
+                {
+                    runTask(task, G);
+                    G.pendingTasks.fetch_sub(1);
+                }
+                else if (G.pendingTasks.load() == 0)
+                {
+                    break;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+            LocalDeque = nullptr;
+        }
+
+        // Parallel engine. The calling thread is worker 0 and visits the entry block. A deque holds each
+        // queued instruction and edge at most once, which bounds its capacity.
+        void solveParallel(unsigned entry, FunctionGraph &G, unsigned numThreads)
+        {
+            size_t capacity = G.insts.size() + G.succs.size();
+            while (G.deques.size() < numThreads)
+            {
+                G.deques.push_back(std::make_unique<StealingDeque>());
+            }
+            for (unsigned workerIdx = 0; workerIdx < numThreads; ++workerIdx)
+            {
+                G.deques[workerIdx]->reset(capacity);
+            }
+            G.queuedInsts.assign(G.insts.size());
+            G.pendingTasks = 0;
+            G.parallel = true;
+
+            LocalDeque = G.deques[0].get();
+            visitBlock(entry, G);
+            for (unsigned workerIdx = 1; workerIdx < numThreads; ++workerIdx)
+            {
+                G.workers.emplace_back([this, workerIdx, numThreads, &G] { runWorker(workerIdx, numThreads, G); });
+            }
+            runWorker(0, numThreads, G);
+            for (auto &worker : G.workers)
+            {
+                worker.join();
+            }
+            G.workers.clear();
+
+            G.parallel = false;
+        }
+
+        void getAnalysisUsage(AnalysisUsage &AU) const override
+        {
+            if (EdgeFacts)
+            {
+                AU.addRequired<DominatorTreeWrapperPass>();
+            }
+        }
+
+        // Main pass logic
+        bool runOnFunction(Function &F) override
+        {
+            FunctionGraph &G = Graph;
+            buildGraph(F, G);
+            if (EdgeFacts)
+            {
+                collectEdgeFacts(getAnalysis<DominatorTreeWrapperPass>().getDomTree(), G);
+            }
+
+            unsigned entry = G.blockNum[&F.getEntryBlock()];
+            // Ranges and known bits are not atomic, so those modes always run the sequential engine
+            if (Threads > 1 && !RangeMode && !KnownBitsMode && G.insts.size() >= ParallelMinInsts)
+            {
+                solveParallel(entry, G, Threads);
+            }
+            else
+            {
+                solveSequential(entry, G);
+            }
+
+            if (ReportStats)
+            {
+                printStats(F, G);
+            }
+
+            // Replace constants and remove redundant instructions, mapping the results back to the IR
+            for (unsigned instIdx = 0; instIdx < G.insts.size(); ++instIdx)
+            {
+                LatticeCell constVal{G.value[instIdx].val.load()};
+                unsigned bitWidth = G.nodes[instIdx].bitWidth;
+                if (G.nodes[instIdx].definesValue && bitWidth != 0 && constVal.isConstant())
+                {
+                    Instruction *inst = G.insts[instIdx];
+                    const fltSemantics *semantics = G.nodes[instIdx].semantics;
+                    APInt bits = G.pool.decode(constVal, bitWidth);
+                    Constant *constant = semantics ? ConstantFP::get(inst->getContext(), APFloat(*semantics, bits))
+                                                   : ConstantInt::get(inst->getType(), bits);
                     inst->replaceAllUsesWith(constant);
                     inst->eraseFromParent();
+                    continue;
+                }
+
+                // Uses an equality fact holds for take its constant
+                ArrayRef<FunctionGraph::Operand> operands = G.operandsOf(instIdx);
+                for (unsigned oprIdx = 0; oprIdx < operands.size(); ++oprIdx)
+                {
+                    if (hasEqualityFact(operands[oprIdx], G))
+                    {
+                        G.insts[instIdx]->setOperand(oprIdx, G.facts[operands[oprIdx].fact].constant);
+                    }
                 }
             }
 
@@ -361,6 +1522,7 @@ namespace
 
 } // end of anonymous namespace
 
+const unsigned SSAConstantPropagation::FunctionGraph::NoIndex;
 char SSAConstantPropagation::ID = 0;
 static RegisterPass<SSAConstantPropagation> X("SSAConstantPropagation", "SSAConstantPropagation Pass",
                                               false /* Only looks at CFG */,
@@ -0,0 +1,6 @@
+int test(int x) {
+int a, r;
+a = (x << 8) & 255;
+r = a + ((x | 1) == 0) * 2 + ((x * 4) & 3);
+return r;
+}
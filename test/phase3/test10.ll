@@ -0,0 +1,32 @@
+; ModuleID = 'test10.ll'
+source_filename = "test10.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind uwtable
+define dso_local i32 @test(i32 %x) #0 {
+entry:
+  %shl = shl i32 %x, 8
+  %and = and i32 %shl, 255
+  %or = or i32 %x, 1
+  %cmp = icmp eq i32 %or, 0
+  %conv = zext i1 %cmp to i32
+  %mul = mul nsw i32 %conv, 2
+  %add = add nsw i32 %and, %mul
+  %mul1 = mul nsw i32 %x, 4
+  %and2 = and i32 %mul1, 3
+  %add3 = add nsw i32 %add, %and2
+  ret i32 %add3
+}
+
+attributes #0 = { noinline nounwind uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 1}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 14.0.0-1ubuntu1.1"}
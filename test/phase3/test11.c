@@ -0,0 +1,19 @@
+int test(int x, int y) {
+int r;
+r = 0;
+if (x == 5)
+r = x * 2;
+if (y != 7) {
+if (y == 7)
+r = r + 100;
+}
+switch (x) {
+case 1:
+r = r + x;
+break;
+case 2:
+r = r + x;
+break;
+}
+return r;
+}
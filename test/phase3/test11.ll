@@ -0,0 +1,63 @@
+; ModuleID = 'test11.ll'
+source_filename = "test11.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind uwtable
+define dso_local i32 @test(i32 %x, i32 %y) #0 {
+entry:
+  %cmp = icmp eq i32 %x, 5
+  br i1 %cmp, label %if.then, label %if.end
+
+if.then:                                          ; preds = %entry
+  %mul = mul nsw i32 %x, 2
+  br label %if.end
+
+if.end:                                           ; preds = %if.then, %entry
+  %r.0 = phi i32 [ %mul, %if.then ], [ 0, %entry ]
+  %cmp1 = icmp ne i32 %y, 7
+  br i1 %cmp1, label %if.then2, label %if.end6
+
+if.then2:                                         ; preds = %if.end
+  %cmp3 = icmp eq i32 %y, 7
+  br i1 %cmp3, label %if.then4, label %if.end5
+
+if.then4:                                         ; preds = %if.then2
+  %add = add nsw i32 %r.0, 100
+  br label %if.end5
+
+if.end5:                                          ; preds = %if.then4, %if.then2
+  %r.1 = phi i32 [ %add, %if.then4 ], [ %r.0, %if.then2 ]
+  br label %if.end6
+
+if.end6:                                          ; preds = %if.end5, %if.end
+  %r.2 = phi i32 [ %r.1, %if.end5 ], [ %r.0, %if.end ]
+  switch i32 %x, label %sw.epilog [
+    i32 1, label %sw.bb
+    i32 2, label %sw.bb8
+  ]
+
+sw.bb:                                            ; preds = %if.end6
+  %add7 = add nsw i32 %r.2, %x
+  br label %sw.epilog
+
+sw.bb8:                                           ; preds = %if.end6
+  %add9 = add nsw i32 %r.2, %x
+  br label %sw.epilog
+
+sw.epilog:                                        ; preds = %if.end6, %sw.bb8, %sw.bb
+  %r.3 = phi i32 [ %r.2, %if.end6 ], [ %add9, %sw.bb8 ], [ %add7, %sw.bb ]
+  ret i32 %r.3
+}
+
+attributes #0 = { noinline nounwind uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 1}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 14.0.0-1ubuntu1.1"}
@@ -0,0 +1,75 @@
+; ModuleID = 'test12.ll'
+; Written by hand: C has no invoke. The value an invoke defines takes every range, so with
+; -sscp-ranges the PHI of it and 0 is not known to be 0, and %q and the branch on it must survive.
+; It has no known bits either, so with -sscp-known-bits the mask in @test_bits must survive.
+source_filename = "test12.ll"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+declare dso_local i32 @g()
+
+declare dso_local i32 @__gxx_personality_v0(...)
+
+; Function Attrs: noinline uwtable
+define dso_local i32 @test(i1 %s) #0 personality i8* bitcast (i32 (...)* @__gxx_personality_v0 to i8*) {
+entry:
+  br i1 %s, label %a, label %b
+
+a:                                                ; preds = %entry
+  %v = invoke i32 @g()
+          to label %join unwind label %lpad
+
+b:                                                ; preds = %entry
+  br label %join
+
+join:                                             ; preds = %b, %a
+  %p = phi i32 [ %v, %a ], [ 0, %b ]
+  %q = icmp eq i32 %p, 0
+  br i1 %q, label %zero, label %nonzero
+
+zero:                                             ; preds = %join
+  ret i32 %p
+
+nonzero:                                          ; preds = %join
+  ret i32 1
+
+lpad:                                             ; preds = %a
+  %lp = landingpad { i8*, i32 }
+          cleanup
+  resume { i8*, i32 } %lp
+}
+
+; Function Attrs: noinline uwtable
+define dso_local i32 @test_bits(i1 %s) #0 personality i8* bitcast (i32 (...)* @__gxx_personality_v0 to i8*) {
+entry:
+  br i1 %s, label %a, label %b
+
+a:                                                ; preds = %entry
+  %v = invoke i32 @g()
+          to label %join unwind label %lpad
+
+b:                                                ; preds = %entry
+  br label %join
+
+join:                                             ; preds = %b, %a
+  %p = phi i32 [ %v, %a ], [ 0, %b ]
+  %m = and i32 %p, 255
+  ret i32 %m
+
+lpad:                                             ; preds = %a
+  %lp = landingpad { i8*, i32 }
+          cleanup
+  resume { i8*, i32 } %lp
+}
+
+attributes #0 = { noinline uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 1}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 14.0.0-1ubuntu1.1"}
@@ -0,0 +1,49 @@
+; ModuleID = 'test4.ll'
+; Written by hand: C has no invoke. The value an invoke defines is not constant, so %c,
+; the branch on it and the PHI must all survive the SSA pass, also with -sscp-ranges and
+; -sscp-known-bits, where the value takes every range and no bit is known.
+source_filename = "test4.ll"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+declare dso_local i32 @g()
+
+declare dso_local i32 @__gxx_personality_v0(...)
+
+; Function Attrs: noinline uwtable
+define dso_local i32 @test(i1 %skip) #0 personality i8* bitcast (i32 (...)* @__gxx_personality_v0 to i8*) {
+entry:
+  br i1 %skip, label %m, label %call
+
+call:                                             ; preds = %entry
+  %r = invoke i32 @g()
+          to label %cont unwind label %lpad
+
+cont:                                             ; preds = %call
+  %c = icmp eq i32 %r, 0
+  br i1 %c, label %m, label %m2
+
+m2:                                               ; preds = %cont
+  br label %m
+
+m:                                                ; preds = %m2, %cont, %entry
+  %p = phi i32 [ 1, %entry ], [ 1, %cont ], [ 2, %m2 ]
+  ret i32 %p
+
+lpad:                                             ; preds = %call
+  %lp = landingpad { i8*, i32 }
+          cleanup
+  resume { i8*, i32 } %lp
+}
+
+attributes #0 = { noinline uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 1}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 14.0.0-1ubuntu1.1"}
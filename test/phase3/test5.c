@@ -0,0 +1,13 @@
+int test() {
+int i, s;
+s = 0;
+for (i = 0; i < 100; i++) {
+if (i < 100)
+s = s + 1;
+else
+s = s + 2;
+if (i >= 0)
+s = s + i;
+}
+return s + (i > 99);
+}
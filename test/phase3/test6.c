@@ -0,0 +1,26 @@
+int test(int x) {
+int k, r;
+k = 2;
+switch (x) {
+case 1:
+r = 7;
+break;
+case 2:
+if (k != 2) {
+r = x;
+break;
+}
+r = 7;
+break;
+default:
+r = 7;
+}
+return r;
+}
+
+int test_or(int x) {
+int a, b;
+a = 0;
+b = 1;
+return a || b || x;
+}
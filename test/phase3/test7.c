@@ -0,0 +1,19 @@
+unsigned long long test() {
+unsigned long long a, b;
+unsigned __int128 c, d;
+a = 18446744073709551615ULL;
+b = a + 2;
+c = (unsigned __int128)a * a;
+d = c >> 64;
+return b + (unsigned long long)d;
+}
+
+unsigned __int128 test_pool(int x) {
+unsigned __int128 one, c;
+one = 1;
+if (x)
+c = one << 100;
+else
+c = one << 100;
+return c + one;
+}
@@ -0,0 +1,49 @@
+; ModuleID = 'test7.ll'
+source_filename = "test7.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind uwtable
+define dso_local i64 @test() #0 {
+entry:
+  %add = add i64 -1, 2
+  %conv = zext i64 -1 to i128
+  %conv1 = zext i64 -1 to i128
+  %mul = mul i128 %conv, %conv1
+  %shr = lshr i128 %mul, 64
+  %conv2 = trunc i128 %shr to i64
+  %add3 = add i64 %add, %conv2
+  ret i64 %add3
+}
+
+; Function Attrs: noinline nounwind uwtable
+define dso_local i128 @test_pool(i32 %x) #0 {
+entry:
+  %tobool = icmp ne i32 %x, 0
+  br i1 %tobool, label %if.then, label %if.else
+
+if.then:                                          ; preds = %entry
+  %shl = shl i128 1, 100
+  br label %if.end
+
+if.else:                                          ; preds = %entry
+  %shl1 = shl i128 1, 100
+  br label %if.end
+
+if.end:                                           ; preds = %if.else, %if.then
+  %c.0 = phi i128 [ %shl, %if.then ], [ %shl1, %if.else ]
+  %add = add i128 %c.0, 1
+  ret i128 %add
+}
+
+attributes #0 = { noinline nounwind uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 1}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 14.0.0-1ubuntu1.1"}
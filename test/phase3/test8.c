@@ -0,0 +1,8 @@
+int test() {
+double z, nz, n, a;
+z = 0.0;
+nz = -0.0;
+n = z / z;
+a = n + 1.0;
+return (z == nz) + (n != n) * 2 + (1.0 / nz < 0.0) * 4 + (a == a) * 8 + (1.0 / (nz + z) > 0.0) * 16;
+}
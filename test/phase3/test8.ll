@@ -0,0 +1,45 @@
+; ModuleID = 'test8.ll'
+source_filename = "test8.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind uwtable
+define dso_local i32 @test() #0 {
+entry:
+  %div = fdiv double 0.000000e+00, 0.000000e+00
+  %add = fadd double %div, 1.000000e+00
+  %cmp = fcmp oeq double 0.000000e+00, -0.000000e+00
+  %conv = zext i1 %cmp to i32
+  %cmp1 = fcmp une double %div, %div
+  %conv2 = zext i1 %cmp1 to i32
+  %mul = mul nsw i32 %conv2, 2
+  %add3 = add nsw i32 %conv, %mul
+  %div4 = fdiv double 1.000000e+00, -0.000000e+00
+  %cmp5 = fcmp olt double %div4, 0.000000e+00
+  %conv6 = zext i1 %cmp5 to i32
+  %mul7 = mul nsw i32 %conv6, 4
+  %add8 = add nsw i32 %add3, %mul7
+  %cmp9 = fcmp oeq double %add, %add
+  %conv10 = zext i1 %cmp9 to i32
+  %mul11 = mul nsw i32 %conv10, 8
+  %add12 = add nsw i32 %add8, %mul11
+  %add13 = fadd double -0.000000e+00, 0.000000e+00
+  %div14 = fdiv double 1.000000e+00, %add13
+  %cmp15 = fcmp ogt double %div14, 0.000000e+00
+  %conv16 = zext i1 %cmp15 to i32
+  %mul17 = mul nsw i32 %conv16, 16
+  %add18 = add nsw i32 %add12, %mul17
+  ret i32 %add18
+}
+
+attributes #0 = { noinline nounwind uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 1}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 14.0.0-1ubuntu1.1"}
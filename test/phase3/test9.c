@@ -0,0 +1,11 @@
+int test(int x) {
+int i, r;
+unsigned char c;
+if (x)
+i = 0;
+else
+i = 1;
+c = x;
+r = (i < 100) + ((int)c < 256) * 2;
+return r;
+}
@@ -0,0 +1,41 @@
+; ModuleID = 'test9.ll'
+source_filename = "test9.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind uwtable
+define dso_local i32 @test(i32 %x) #0 {
+entry:
+  %tobool = icmp ne i32 %x, 0
+  br i1 %tobool, label %if.then, label %if.else
+
+if.then:                                          ; preds = %entry
+  br label %if.end
+
+if.else:                                          ; preds = %entry
+  br label %if.end
+
+if.end:                                           ; preds = %if.else, %if.then
+  %i.0 = phi i32 [ 0, %if.then ], [ 1, %if.else ]
+  %conv = trunc i32 %x to i8
+  %cmp = icmp slt i32 %i.0, 100
+  %conv1 = zext i1 %cmp to i32
+  %conv2 = zext i8 %conv to i32
+  %cmp3 = icmp slt i32 %conv2, 256
+  %conv4 = zext i1 %cmp3 to i32
+  %mul = mul nsw i32 %conv4, 2
+  %add = add nsw i32 %conv1, %mul
+  ret i32 %add
+}
+
+attributes #0 = { noinline nounwind uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 1}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 14.0.0-1ubuntu1.1"}